@@ -0,0 +1,86 @@
+#include <QtDebug>
+
+#include "qx_action.h"
+#include "qx_atom_table.h"
+
+QxAction::QxAction()
+{
+    // Intentionally left empty.
+}
+
+QxAction::QxAction(int atom, const QJSValue &message)
+    : d_(new Data())
+{
+    d_->atom = atom;
+    d_->type = QxAtomTable::name(atom);
+    d_->message = message;
+    d_->has_message = true;
+}
+
+QxAction::QxAction(int atom, const QVariant &payload)
+    : d_(new Data())
+{
+    d_->atom = atom;
+    d_->type = QxAtomTable::name(atom);
+    d_->payload = payload;
+    d_->native = true;
+    d_->has_payload = true;
+}
+
+bool QxAction::isNull() const
+{
+    return !d_;
+}
+
+int QxAction::atom() const
+{
+    return d_ ? d_->atom : 0;
+}
+
+QString QxAction::type() const
+{
+    return d_ ? d_->type : QString();
+}
+
+bool QxAction::isNative() const
+{
+    return d_ && d_->native;
+}
+
+bool QxAction::isMaterialized() const
+{
+    return d_ && d_->has_message;
+}
+
+QJSValue QxAction::message(QJSEngine *engine) const
+{
+    if (!d_) {
+        return QJSValue();
+    }
+
+    if (!d_->has_message) {
+        if (!engine) {
+            qWarning() << "QxAppDispatcher::dispatch() - Unexpected error: engine is not available.";
+            return QJSValue();
+        }
+
+        d_->message = engine->toScriptValue<QVariant>(d_->payload);
+        d_->has_message = true;
+    }
+
+    return d_->message;
+}
+
+QVariant QxAction::payload() const
+{
+    if (!d_) {
+        return QVariant();
+    }
+
+    if (!d_->has_payload) {
+        d_->payload = d_->message.toVariant();
+        d_->has_payload = true;
+    }
+
+    return d_->payload;
+}
@@ -0,0 +1,56 @@
+#ifndef QX_ACTION_H
+#define QX_ACTION_H
+
+#include <QExplicitlySharedDataPointer>
+#include <QJSEngine>
+#include <QJSValue>
+#include <QSharedData>
+#include <QString>
+#include <QVariant>
+
+/// QxAction is the envelope of an action travelling through QxDispatcher.
+/// It holds either a JavaScript message or a native payload (QVariant, QVariantMap or a gadget),
+/// and converts to the other form once, on first access. Copies share the converted value,
+/// so a fan-out pays for the conversion at most once.
+class QxAction
+{
+public:
+    QxAction();
+    QxAction(int atom, const QJSValue &message);
+    QxAction(int atom, const QVariant &payload);
+
+    bool isNull() const;
+
+    int atom() const;
+
+    /// The canonical type string.
+    QString type() const;
+
+    /// Return true if the action was created from a native payload.
+    bool isNative() const;
+
+    /// Return true if the JavaScript message is available without conversion.
+    bool isMaterialized() const;
+
+    /// Obtain the message as a JavaScript value. It is built by engine on first access.
+    QJSValue message(QJSEngine *engine) const;
+
+    /// Obtain the message as QVariant. It is converted from the JavaScript message on first access.
+    QVariant payload() const;
+
+private:
+    struct Data : public QSharedData
+    {
+        int atom = 0;
+        QString type;
+        QVariant payload;
+        QJSValue message;
+        bool native = false;
+        bool has_payload = false;
+        bool has_message = false;
+    };
+
+    QExplicitlySharedDataPointer<Data> d_;
+};
+
+#endif // QX_ACTION_H
@@ -0,0 +1,213 @@
+#include <QtDebug>
+
+#include "qx_action_queue.h"
+#include "quix_functions.h"
+
+namespace {
+
+// Delivered entries are trimmed once they exceed this count and half of the list.
+constexpr int kCompactThreshold = 1024;
+
+} // namespace
+
+QxActionQueue::QxActionQueue()
+    : expired_count_(0)
+{
+    // Intentionally left empty.
+}
+
+bool QxActionQueue::isEmpty() const
+{
+    return size() == 0;
+}
+
+int QxActionQueue::size() const
+{
+    int count = 0;
+
+    for (const Queue &queue : lanes_) {
+        count += queue.actions.size() - queue.head;
+    }
+
+    return count;
+}
+
+int QxActionQueue::size(int lane) const
+{
+    if (lane < 0 || lane >= LaneCount) {
+        return 0;
+    }
+
+    const Queue &queue = lanes_[lane];
+    return queue.actions.size() - queue.head;
+}
+
+void QxActionQueue::reserve(int size, int lane)
+{
+    Queue &queue = lanes_[lane];
+    queue.actions.reserve(queue.actions.size() + size);
+}
+
+void QxActionQueue::enqueue(const QxAction &action)
+{
+    enqueue(action, lane(action.atom()), QDeadlineTimer(QDeadlineTimer::Forever));
+}
+
+void QxActionQueue::enqueue(const QxAction &action, int lane, QDeadlineTimer deadline)
+{
+    if (lane < 0 || lane >= LaneCount) {
+        lane = NormalLane;
+    }
+
+    const int atom = action.atom();
+    auto rule = rules_.constFind(atom);
+
+    if (rule != rules_.constEnd() && rule->policy != KeepAll) {
+        auto pending = pending_.constFind(atom);
+
+        if (pending != pending_.constEnd()) {
+            Queue &queue = lanes_[pending->lane];
+            Entry &queued = queue.actions[pending->sequence - queue.base];
+
+            queued.deadline = deadline;
+
+            if (rule->policy == LatestWins) {
+                queued.action = action;
+                return;
+            }
+
+            // Nothing of the queue is held across the call. A merge function which dispatches
+            // re-enters enqueue(), and may reallocate the lane or change the rules.
+            const QJSValue merge = rule->merge;
+            const QJSValue previous = queued.action.message(engine_.data());
+            QJSValue merged = merge.call(QJSValueList() << previous << action.message(engine_.data()));
+
+            QxAction result(atom, merged);
+
+            if (merged.isError()) {
+                QuixFlux::printException(merged);
+                result = action;
+            }
+
+            auto current = pending_.constFind(atom);
+
+            if (current == pending_.constEnd()) {
+                // The pending action is gone. Queue the result in its place.
+                enqueue(result, lane, deadline);
+                return;
+            }
+
+            Queue &target = lanes_[current->lane];
+            target.actions[current->sequence - target.base].action = result;
+            return;
+        }
+
+        Position position;
+        position.lane = lane;
+        position.sequence = lanes_[lane].base + lanes_[lane].actions.size();
+        pending_.insert(atom, position);
+    }
+
+    Entry entry;
+    entry.action = action;
+    entry.deadline = deadline;
+    lanes_[lane].actions.append(entry);
+}
+
+void QxActionQueue::append(const QxAction &action)
+{
+    Entry entry;
+    entry.action = action;
+    lanes_[NormalLane].actions.append(entry);
+}
+
+bool QxActionQueue::dequeue(QxAction *action)
+{
+    for (int lane = 0 ; lane < LaneCount ; lane++) {
+        Queue &queue = lanes_[lane];
+
+        while (queue.head < queue.actions.size()) {
+            const qint64 sequence = queue.base + queue.head;
+            Entry entry = std::move(queue.actions[queue.head]);
+            pop(queue);
+
+            if (!pending_.isEmpty()) {
+                auto pending = pending_.find(entry.action.atom());
+                if (pending != pending_.end() &&
+                    pending->lane == lane &&
+                    pending->sequence == sequence) {
+                    pending_.erase(pending);
+                }
+            }
+
+            if (entry.deadline.hasExpired()) {
+                expired_count_++;
+                continue;
+            }
+
+            *action = entry.action;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void QxActionQueue::setPolicy(int atom, Policy policy, const QJSValue &merge)
+{
+    if (policy == KeepAll) {
+        rules_.remove(atom);
+        pending_.remove(atom);
+        return;
+    }
+
+    if (policy == Merge && !merge.isCallable()) {
+        qWarning() << "QxDispatcher: A merge function is required. The policy falls back to LatestWins.";
+        policy = LatestWins;
+    }
+
+    Rule rule;
+    rule.policy = policy;
+    rule.merge = merge;
+    rules_.insert(atom, rule);
+}
+
+int QxActionQueue::lane(int atom) const
+{
+    return type_lanes_.value(atom, NormalLane);
+}
+
+void QxActionQueue::setLane(int atom, int lane)
+{
+    if (lane == NormalLane) {
+        type_lanes_.remove(atom);
+    } else {
+        type_lanes_.insert(atom, lane);
+    }
+}
+
+int QxActionQueue::expiredCount() const
+{
+    return expired_count_;
+}
+
+void QxActionQueue::setEngine(QQmlEngine *engine)
+{
+    engine_ = engine;
+}
+
+void QxActionQueue::pop(Queue &queue)
+{
+    queue.head++;
+
+    if (queue.head == queue.actions.size()) {
+        // The storage is kept for the next actions.
+        queue.base += queue.actions.size();
+        queue.actions.clear();
+        queue.head = 0;
+    } else if (queue.head > kCompactThreshold && queue.head * 2 > queue.actions.size()) {
+        queue.actions.remove(0, queue.head);
+        queue.base += queue.head;
+        queue.head = 0;
+    }
+}
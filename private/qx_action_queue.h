@@ -0,0 +1,115 @@
+#ifndef QX_ACTION_QUEUE_H
+#define QX_ACTION_QUEUE_H
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QJSValue>
+#include <QList>
+#include <QPointer>
+#include <QQmlEngine>
+
+#include "qx_action.h"
+
+/// QxActionQueue holds the actions waiting for delivery in QxDispatcher.
+/// Actions are placed in priority lanes. A lane is drained before the lanes of lower priority,
+/// and actions within a lane are delivered first come first served,
+/// unless their type has a coalescing policy.
+class QxActionQueue
+{
+public:
+    enum Policy {
+        // Every action is delivered.
+        KeepAll,
+        // A pending action is replaced by a new action of the same type. It keeps its position.
+        LatestWins,
+        // A pending action is replaced by the result of merge(pending, new). It keeps its position.
+        Merge
+    };
+
+    enum Lane {
+        HighLane,
+        NormalLane,
+        LowLane,
+        LaneCount
+    };
+
+    QxActionQueue();
+
+    bool isEmpty() const;
+
+    int size() const;
+
+    int size(int lane) const;
+
+    void reserve(int size, int lane = NormalLane);
+
+    /// Append an action to the default lane of its type.
+    void enqueue(const QxAction &action);
+
+    void enqueue(const QxAction &action, int lane, QDeadlineTimer deadline);
+
+    /// Append an action to the normal lane. Its type's lane and coalescing policy are ignored.
+    void append(const QxAction &action);
+
+    /// Take the next action. Actions past their deadline are dropped. Returns false if nothing is left.
+    bool dequeue(QxAction *action);
+
+    void setPolicy(int atom, Policy policy, const QJSValue &merge = QJSValue());
+
+    /// Obtain the default lane of a type.
+    int lane(int atom) const;
+
+    void setLane(int atom, int lane);
+
+    /// The number of actions dropped due to their deadline.
+    int expiredCount() const;
+
+    /// Set the engine used to materialize native payloads for merge functions.
+    void setEngine(QQmlEngine *engine);
+
+private:
+    struct Rule
+    {
+        Policy policy = KeepAll;
+        QJSValue merge;
+    };
+
+    struct Entry
+    {
+        QxAction action;
+        QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever);
+    };
+
+    struct Queue
+    {
+        // Queued actions. Entries before head are already delivered.
+        QList<Entry> actions;
+        int head = 0;
+
+        // Sequence number of actions[0]
+        qint64 base = 0;
+    };
+
+    struct Position
+    {
+        int lane = NormalLane;
+        qint64 sequence = 0;
+    };
+
+    void pop(Queue &queue);
+
+    Queue lanes_[LaneCount];
+
+    QHash<int, Rule> rules_;
+
+    QHash<int, int> type_lanes_;
+
+    // Position of the pending action per coalescing type
+    QHash<int, Position> pending_;
+
+    int expired_count_;
+
+    QPointer<QQmlEngine> engine_;
+};
+
+#endif // QX_ACTION_QUEUE_H
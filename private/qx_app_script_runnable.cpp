@@ -1,44 +1,22 @@
 #include <QtDebug>
-#include <QUuid>
 
 #include "qx_app_script_runnable.h"
-#include "qx_app_script_dispatcher_wrapper.h"
-#include "../qx_app_dispatcher.h"
-
-QxAppScriptRunnable::QxAppScriptRunnable(QObject *parent)
-    : QObject{parent}
-    , engine_(0)
-    , next_(0)
-    , is_signal_condition_(false)
-    , is_once_only_(true)
-{
-    // Intentionally left empty.
-}
 
-QxAppScriptRunnable::~QxAppScriptRunnable()
-{
-    release();
-}
+namespace {
 
-QJSValue QxAppScriptRunnable::script() const
-{
-    return script_;
-}
+// A runnable id is made of the slot index and the slot generation, which has 15 bits.
+// A slot serves 32768 runnables. It is then retired instead of wrapping around,
+// so a stale chain handle never resolves to a later runnable.
+constexpr int kSlotBits = 16;
+constexpr int kSlotMask = (1 << kSlotBits) - 1;
+constexpr int kGenerationMask = 0x7fff;
 
-void QxAppScriptRunnable::setScript(const QJSValue &script)
-{
-    script_ = script;
 }
 
-QString QxAppScriptRunnable::type() const
-{
-    return type_;
-}
-
-void QxAppScriptRunnable::run(QJSValue message)
+void QxAppScriptRunnable::run(const QJSValue &message) const
 {
     QJSValueList args;
-    if (is_signal_condition_ &&
+    if (is_signal_condition &&
         message.hasProperty("length")) {
         int count = message.property("length").toInt();
         for (int i = 0 ; i < count;i++) {
@@ -47,7 +25,10 @@ void QxAppScriptRunnable::run(QJSValue message)
     } else {
         args << message;
     }
-    QJSValue ret = script_.call(args);
+
+    // Hold a copy. The runnable may be freed by the script.
+    QJSValue function = script;
+    QJSValue ret = function.call(args);
 
     if (ret.isError()) {
         QString message = QString("%1:%2: %3: %4")
@@ -59,97 +40,95 @@ void QxAppScriptRunnable::run(QJSValue message)
     }
 }
 
-QxAppScriptRunnable *QxAppScriptRunnable::next() const
-{
-    return next_;
-}
-
-void QxAppScriptRunnable::setNext(QxAppScriptRunnable *next)
-{
-    next_ = next;
-}
-
-void QxAppScriptRunnable::setCondition(QJSValue condition)
+void QxAppScriptRunnable::release()
 {
-    condition_ = condition;
-
-    if (condition.isString()) {
-        setType(condition.toString());
-        is_signal_condition_ = false;
-    } else if (condition.isObject() && condition.hasProperty("connect")) {
-        Q_ASSERT(!engine_.isNull());
+    if (!condition.isNull() &&
+        condition.isObject() &&
+        condition.hasProperty("disconnect")) {
 
-        QString type = QString("QuixFlux.QxAppScript.%1").arg(QUuid::createUuid().toString());
-        setType(type);
+        QJSValue disconnect = condition.property("disconnect");
+        QJSValueList args;
+        args << callback;
 
-        QString generator = "(function(dispatcher) { return function() {dispatcher.dispatch(arguments)}})";
-        QxAppDispatcher *dispatcher = QxAppDispatcher::instance(engine_);
-        QxAppScriptDispatcherWrapper *wrapper = new QxAppScriptDispatcherWrapper();
-        wrapper->setType(type);
-        wrapper->setDispatcher(dispatcher);
+        disconnect.callWithInstance(condition,args);
+    }
 
-        QJSValue generator_func = engine_->evaluate(generator);
+    condition = QJSValue();
+    callback = QJSValue();
+}
 
-        QJSValueList args;
-        args << engine_->newQObject(wrapper);
-        QJSValue callback = generator_func.call(args);
+int QxAppScriptRunnablePool::create()
+{
+    int slot;
 
-        args.clear();
-        args << callback;
+    if (free_slots_.isEmpty()) {
+        slot = entries_.size();
 
-        QJSValue connect = condition.property("connect");
-        connect.callWithInstance(condition,args);
+        if (slot > kSlotMask) {
+            qWarning() << "AppScript: Too many callbacks are registered. The limit is" << kSlotMask + 1;
+            return -1;
+        }
 
-        callback_ = callback;
-        is_signal_condition_ = true;
+        entries_.append(Entry());
     } else {
-        qWarning() << "AppScript: Invalid condition type";
+        slot = free_slots_.takeLast();
     }
-}
 
-void QxAppScriptRunnable::setEngine(QQmlEngine *engine)
-{
-    engine_ = engine;
+    Entry &entry = entries_[slot];
+    entry.used = true;
+
+    return (entry.generation << kSlotBits) | slot;
 }
 
-void QxAppScriptRunnable::release()
+QxAppScriptRunnable *QxAppScriptRunnablePool::at(int id)
 {
-    if (!condition_.isNull() &&
-        condition_.isObject() &&
-        condition_.hasProperty("disconnect")) {
+    const int slot = slotOf(id);
 
-        QJSValue disconnect = condition_.property("disconnect");
-        QJSValueList args;
-        args << callback_;
+    if (slot < 0 || slot >= entries_.size()) {
+        return nullptr;
+    }
+
+    Entry &entry = entries_[slot];
 
-        disconnect.callWithInstance(condition_,args);
+    if (!entry.used || entry.generation != (id >> kSlotBits)) {
+        return nullptr;
     }
 
-    condition_ = QJSValue();
-    callback_ = QJSValue();
+    return &entry.runnable;
 }
 
-bool QxAppScriptRunnable::isOnceOnly() const
+void QxAppScriptRunnablePool::free(int id)
 {
-    return is_once_only_;
-}
+    while (QxAppScriptRunnable *runnable = at(id)) {
+        const int next = runnable->next;
+        runnable->release();
+
+        Entry &entry = entries_[slotOf(id)];
+        entry.runnable = QxAppScriptRunnable();
+        entry.used = false;
+
+        // A slot whose generation is exhausted is retired. Its ids are all spent.
+        if (entry.generation < kGenerationMask) {
+            entry.generation++;
+            free_slots_.append(slotOf(id));
+        }
 
-void QxAppScriptRunnable::setIsOnceOnly(bool is_once_only)
-{
-    is_once_only_ = is_once_only;
+        id = next;
+    }
 }
 
-QxAppScriptRunnable *QxAppScriptRunnable::then(QJSValue condition, QJSValue value)
+void QxAppScriptRunnablePool::clear()
 {
-    QxAppScriptRunnable *runnable = new QxAppScriptRunnable(this);
-    runnable->setEngine(engine_.data());
-    runnable->setCondition(condition);
-    runnable->setScript(value);
-    setNext(runnable);
-    return runnable;
+    for (int slot = 0 ; slot < entries_.size() ; slot++) {
+        Entry &entry = entries_[slot];
+
+        if (entry.used) {
+            free((entry.generation << kSlotBits) | slot);
+        }
+    }
 }
 
-void QxAppScriptRunnable::setType(const QString &type)
+int QxAppScriptRunnablePool::slotOf(int id)
 {
-    type_ = type;
+    return id < 0 ? -1 : (id & kSlotMask);
 }
@@ -1,56 +1,66 @@
 #ifndef QX_APP_SCRIPT_RUNNABLE_H
 #define QX_APP_SCRIPT_RUNNABLE_H
 
-#include <QObject>
 #include <QJSValue>
-#include <QQmlEngine>
-#include <QPointer>
+#include <QList>
 
-/// QxAppScriptRunnable handles registered callback in QxAppScript
-class QxAppScriptRunnable : public QObject
+/// QxAppScriptRunnable is a callback registered in QxAppScript. It waits for a message type or a signal.
+/// It is a plain value kept in the pool of its script, and runnables chained by then() are linked by id.
+class QxAppScriptRunnable
 {
-    Q_OBJECT
-    QML_ANONYMOUS
 public:
-    explicit QxAppScriptRunnable(QObject *parent = nullptr);
-    ~QxAppScriptRunnable();
+    /// Call the script with message. If the condition is a signal, message holds its arguments.
+    void run(const QJSValue &message) const;
 
-    QJSValue script() const;
-    void setScript(const QJSValue &script);
+    /// Disconnect the callback from the signal of the condition.
+    void release();
 
-    QString type() const;
+    QJSValue script;
+    QJSValue condition;
 
-    void run(QJSValue message);
+    // The function connected to the signal of the condition
+    QJSValue callback;
 
-    QxAppScriptRunnable *next() const;
-    void setNext(QxAppScriptRunnable *next);
+    // The atom of the message type to wait for, or 0 if the condition is a signal.
+    int atom = 0;
 
-    void setCondition(QJSValue condition);
+    bool is_signal_condition = false;
+    bool is_once_only = true;
 
-    void setEngine(QQmlEngine *engine);
+    // The id of the runnable chained by then(), or -1.
+    int next = -1;
+};
 
-    void release();
+/// QxAppScriptRunnablePool stores the runnables of a script in reusable slots.
+/// An id combines a slot with its generation, so the id of a freed runnable never refers to its successor.
+/// A slot whose generation is exhausted is retired rather than reused.
+class QxAppScriptRunnablePool
+{
+public:
+    /// Allocate a runnable. Returns its id, or -1 if all the slots are in use.
+    int create();
 
-    bool isOnceOnly() const;
-    void setIsOnceOnly(bool is_once_only);
+    /// Obtain the runnable of id, or nullptr if it is freed. The pointer is invalidated by create().
+    QxAppScriptRunnable *at(int id);
 
-signals:
+    /// Release and free the runnable of id, and the runnables chained to it.
+    void free(int id);
 
-public slots:
-    QxAppScriptRunnable *then(QJSValue condition, QJSValue value);
+    /// Release and free every runnable.
+    void clear();
 
 private:
-    void setType(const QString &type);
+    struct Entry
+    {
+        QxAppScriptRunnable runnable;
+        int generation = 0;
+        bool used = false;
+    };
 
-    QJSValue script_;
-    QString type_;
-    QxAppScriptRunnable *next_;
-    QPointer<QQmlEngine> engine_;
+    static int slotOf(int id);
 
-    QJSValue condition_;
-    QJSValue callback_;
-    bool is_signal_condition_;
-    bool is_once_only_;
+    QList<Entry> entries_;
+    QList<int> free_slots_;
 };
 
 #endif // QX_APP_SCRIPT_RUNNABLE_H
@@ -0,0 +1,110 @@
+#include <QHash>
+#include <QReadWriteLock>
+
+#include "qx_atom_table.h"
+
+namespace {
+
+struct QxAtomStorage
+{
+    QReadWriteLock lock;
+    QHash<QString, int> atoms;
+    QStringList names;
+};
+
+Q_GLOBAL_STATIC(QxAtomStorage, atomStorage)
+
+// The most recent hit of each thread. Type strings travelling along the dispatch path
+// share data with the canonical copy, so they are usually recognized without hashing.
+struct QxAtomCache
+{
+    QString type;
+    int atom = 0;
+};
+
+thread_local QxAtomCache atom_cache;
+
+bool hitCache(const QString &type)
+{
+    if (atom_cache.atom == 0) {
+        return false;
+    }
+
+    if (atom_cache.type.constData() == type.constData() &&
+        atom_cache.type.size() == type.size()) {
+        return true;
+    }
+
+    return atom_cache.type == type;
+}
+
+} // namespace
+
+int QxAtomTable::intern(const QString &type)
+{
+    int atom = lookup(type);
+    if (atom > 0) {
+        return atom;
+    }
+
+    QxAtomStorage *storage = atomStorage();
+    QWriteLocker locker(&storage->lock);
+
+    atom = storage->atoms.value(type, 0);
+    if (atom == 0) {
+        storage->names.append(type);
+        atom = storage->names.size();
+        storage->atoms.insert(type, atom);
+    }
+
+    atom_cache.type = storage->names.at(atom - 1);
+    atom_cache.atom = atom;
+
+    return atom;
+}
+
+QList<int> QxAtomTable::intern(const QStringList &types)
+{
+    QList<int> atoms;
+    atoms.reserve(types.size());
+
+    for (const QString &type : types) {
+        atoms << intern(type);
+    }
+
+    return atoms;
+}
+
+int QxAtomTable::lookup(const QString &type)
+{
+    if (hitCache(type)) {
+        return atom_cache.atom;
+    }
+
+    QxAtomStorage *storage = atomStorage();
+    QReadLocker locker(&storage->lock);
+
+    int atom = storage->atoms.value(type, 0);
+    if (atom > 0) {
+        atom_cache.type = storage->names.at(atom - 1);
+        atom_cache.atom = atom;
+    }
+
+    return atom;
+}
+
+QString QxAtomTable::name(int atom)
+{
+    if (atom > 0 && atom == atom_cache.atom) {
+        return atom_cache.type;
+    }
+
+    QxAtomStorage *storage = atomStorage();
+    QReadLocker locker(&storage->lock);
+
+    if (atom <= 0 || atom > storage->names.size()) {
+        return QString();
+    }
+
+    return storage->names.at(atom - 1);
+}
@@ -0,0 +1,26 @@
+#ifndef QX_ATOM_TABLE_H
+#define QX_ATOM_TABLE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/// QxAtomTable interns action type strings into small integer ids (atoms).
+/// An atom is never released, and the value 0 never refers to a type. It is thread-safe.
+class QxAtomTable
+{
+public:
+    /// Obtain the atom of type. The type is registered if it was not seen before.
+    static int intern(const QString &type);
+
+    /// Obtain the atoms of a list of types.
+    static QList<int> intern(const QStringList &types);
+
+    /// Obtain the atom of type without registering it. Returns 0 if the type is unknown.
+    static int lookup(const QString &type);
+
+    /// Obtain the canonical string of atom. Returns an empty string if the atom is unknown.
+    static QString name(int atom);
+};
+
+#endif // QX_ATOM_TABLE_H
@@ -0,0 +1,80 @@
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+
+#include "qx_engine_registry.h"
+
+namespace {
+
+struct QxEngineStorage
+{
+    QMutex mutex;
+    QHash<QQmlEngine *, QHash<QString, QPointer<QObject>>> engines;
+};
+
+Q_GLOBAL_STATIC(QxEngineStorage, engineStorage)
+
+} // namespace
+
+QObject *QxEngineRegistry::object(QQmlEngine *engine, const QString &key)
+{
+    if (!engine) {
+        return nullptr;
+    }
+
+    QxEngineStorage *storage = engineStorage();
+    QMutexLocker locker(&storage->mutex);
+
+    auto objects = storage->engines.constFind(engine);
+    if (objects == storage->engines.constEnd()) {
+        return nullptr;
+    }
+
+    return objects->value(key).data();
+}
+
+void QxEngineRegistry::insert(QQmlEngine *engine, const QString &key, QObject *object)
+{
+    if (!engine || !object) {
+        return;
+    }
+
+    QxEngineStorage *storage = engineStorage();
+    QMutexLocker locker(&storage->mutex);
+
+    if (!storage->engines.contains(engine)) {
+        // The engine is only used as a key after it is gone.
+        QObject::connect(engine, &QObject::destroyed, [engine]() {
+            QxEngineStorage *storage = engineStorage();
+            if (!storage) {
+                return;
+            }
+
+            QMutexLocker locker(&storage->mutex);
+            storage->engines.remove(engine);
+        });
+    }
+
+    storage->engines[engine].insert(key, object);
+
+    QObject::connect(object, &QObject::destroyed, [engine, key]() {
+        QxEngineStorage *storage = engineStorage();
+        if (!storage) {
+            return;
+        }
+
+        QMutexLocker locker(&storage->mutex);
+
+        auto objects = storage->engines.find(engine);
+
+        // The key may be registered again with another object meanwhile.
+        if (objects != storage->engines.end() && objects->value(key).isNull()) {
+            objects->remove(key);
+        }
+    });
+}
+
+QString QxEngineRegistry::key(const QString &package, int version_major, const QString &type_name)
+{
+    return QString("%1/%2/%3").arg(package).arg(version_major).arg(type_name);
+}
@@ -0,0 +1,23 @@
+#ifndef QX_ENGINE_REGISTRY_H
+#define QX_ENGINE_REGISTRY_H
+
+#include <QObject>
+#include <QQmlEngine>
+#include <QString>
+
+/// QxEngineRegistry keeps the singleton objects of each QQmlEngine, so components can resolve them
+/// without compiling QML. The entries of an engine are removed when it is destroyed. It is thread-safe.
+class QxEngineRegistry
+{
+public:
+    /// Obtain the object registered with key for engine. Returns nullptr if there is none.
+    static QObject *object(QQmlEngine *engine, const QString &key);
+
+    /// Register object with key for engine. The entry is removed when the object is destroyed.
+    static void insert(QQmlEngine *engine, const QString &key, QObject *object);
+
+    /// Obtain the key of a singleton type in a module.
+    static QString key(const QString &package, int version_major, const QString &type_name);
+};
+
+#endif // QX_ENGINE_REGISTRY_H
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "qx_filter_index.h"
+#include "../qx_filter.h"
+
+QxFilterIndex::QxFilterIndex(QObject *parent)
+    : QObject{parent}
+    , next_order_(0)
+{
+    // Intentionally left empty.
+}
+
+void QxFilterIndex::add(QxFilter *filter)
+{
+    if (!filter || order_.contains(filter)) {
+        return;
+    }
+
+    order_.insert(filter, next_order_++);
+    index(filter);
+
+    connect(filter, SIGNAL(typesChanged()), this, SLOT(onTypesChanged()));
+    connect(filter, SIGNAL(destroyed(QObject*)), this, SLOT(onDestroyed(QObject*)));
+
+    emit changed();
+}
+
+void QxFilterIndex::remove(QxFilter *filter)
+{
+    if (!order_.contains(filter)) {
+        return;
+    }
+
+    filter->disconnect(this);
+    unindex(filter);
+    order_.remove(filter);
+
+    emit changed();
+}
+
+bool QxFilterIndex::contains(int atom) const
+{
+    return filters_.contains(atom);
+}
+
+QList<int> QxFilterIndex::atoms() const
+{
+    return filters_.keys();
+}
+
+bool QxFilterIndex::contains(int atom, QxFilter *filter) const
+{
+    auto iter = atoms_.constFind(filter);
+
+    return iter != atoms_.constEnd() && iter->contains(atom);
+}
+
+const QList<QxFilter *> &QxFilterIndex::filters(int atom) const
+{
+    static const QList<QxFilter *> empty;
+
+    auto iter = filters_.constFind(atom);
+
+    return iter != filters_.constEnd() ? *iter : empty;
+}
+
+void QxFilterIndex::onTypesChanged()
+{
+    QxFilter *filter = static_cast<QxFilter *>(sender());
+
+    if (!order_.contains(filter)) {
+        return;
+    }
+
+    unindex(filter);
+    index(filter);
+
+    emit changed();
+}
+
+void QxFilterIndex::onDestroyed(QObject *object)
+{
+    // It is not a QxFilter anymore. The pointer is only used as a key.
+    QxFilter *filter = static_cast<QxFilter *>(object);
+
+    if (!order_.contains(filter)) {
+        return;
+    }
+
+    unindex(filter);
+    order_.remove(filter);
+
+    emit changed();
+}
+
+void QxFilterIndex::index(QxFilter *filter)
+{
+    QList<int> atoms = filter->atoms();
+    std::sort(atoms.begin(), atoms.end());
+    atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+
+    const quint64 order = order_.value(filter);
+
+    for (int atom : std::as_const(atoms)) {
+        QList<QxFilter *> &filters = filters_[atom];
+        auto pos = std::lower_bound(filters.begin(), filters.end(), order, [this](QxFilter *a, quint64 b) {
+            return order_.value(a) < b;
+        });
+        filters.insert(pos, filter);
+    }
+
+    atoms_.insert(filter, atoms);
+}
+
+void QxFilterIndex::unindex(QxFilter *filter)
+{
+    const QList<int> atoms = atoms_.take(filter);
+
+    for (int atom : atoms) {
+        auto filters = filters_.find(atom);
+        if (filters == filters_.end()) {
+            continue;
+        }
+
+        filters->removeOne(filter);
+        if (filters->isEmpty()) {
+            filters_.erase(filters);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef QX_FILTER_INDEX_H
+#define QX_FILTER_INDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+class QxFilter;
+
+/// QxFilterIndex keeps the QxFilter children of a store or a listener by type atom,
+/// so the owner invokes only the matching filters. It follows changes of their types.
+class QxFilterIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QxFilterIndex(QObject *parent = nullptr);
+
+    void add(QxFilter *filter);
+
+    void remove(QxFilter *filter);
+
+    /// Return true if a filter matches atom.
+    bool contains(int atom) const;
+
+    /// Return true if filter is indexed by atom. A copy of filters() is checked with it before each call,
+    /// since a filter may destroy or remove another one while the owner delivers an action to them.
+    bool contains(int atom, QxFilter *filter) const;
+
+    /// Obtain the atoms matched by any filter.
+    QList<int> atoms() const;
+
+    /// Obtain the filters matching atom, in the order they were added.
+    const QList<QxFilter *> &filters(int atom) const;
+
+signals:
+    /// It is emitted when a filter is added or removed, or its types change.
+    void changed();
+
+private slots:
+    void onTypesChanged();
+
+    void onDestroyed(QObject *object);
+
+private:
+    void index(QxFilter *filter);
+
+    void unindex(QxFilter *filter);
+
+    // The order each filter was added in
+    QHash<QxFilter *, quint64> order_;
+
+    // The atoms each filter is indexed by
+    QHash<QxFilter *, QList<int>> atoms_;
+
+    QHash<int, QList<QxFilter *>> filters_;
+
+    quint64 next_order_;
+};
+
+#endif // QX_FILTER_INDEX_H
@@ -5,3 +5,28 @@ QxHook::QxHook(QObject *parent)
 {
     // Intentionally left empty.
 }
+
+void QxHook::dispatch(const QxAction &action, QJSEngine *engine)
+{
+    dispatch(action.type(), action.message(engine));
+}
+
+int QxHook::pendingCount() const
+{
+    return 0;
+}
+
+bool QxHook::hasScriptHandlers(int atom)
+{
+    Q_UNUSED(atom);
+
+    // The default dispatch() materializes every message.
+    return true;
+}
+
+bool QxHook::handles(int atom)
+{
+    Q_UNUSED(atom);
+
+    return true;
+}
@@ -2,18 +2,38 @@
 #define QX_HOOK_H
 
 #include <QObject>
+#include <QJSEngine>
 #include <QJSValue>
 
+#include "qx_action.h"
+
 class QxHook : public QObject
 {
     Q_OBJECT
 public:
     explicit QxHook(QObject *parent = nullptr);
 
-    virtual void dispatch(QString type, QJSValue message) = 0;
+    virtual void dispatch(const QString &type, const QJSValue &message) = 0;
+
+    /// Process an action. Unless it is overridden, the message is materialized by engine for dispatch(type, message).
+    virtual void dispatch(const QxAction &action, QJSEngine *engine);
+
+    /// The number of actions held by the hook, e.g. in flight in an asynchronous middleware.
+    virtual int pendingCount() const;
+
+    /// Return true if a JavaScript handler of the hook may receive a message of type atom.
+    virtual bool hasScriptHandlers(int atom);
+
+    /// Return true if the hook may hold, change or drop an action of type atom. Otherwise it only passes it on.
+    virtual bool handles(int atom);
 
 signals:
     void dispatched(QString type, QJSValue message);
+
+    /// The native form of dispatched(). The message is only materialized if a receiver of the action needs it.
+    void actionDispatched(const QxAction &action);
+
+    void pendingCountChanged();
 };
 
 #endif // QX_HOOK_H
@@ -0,0 +1,77 @@
+#include "qx_inbox.h"
+
+// It is an intrusive MPSC queue as described by Dmitry Vyukov.
+// Producers only exchange the head pointer, and the consumer walks from the tail.
+
+QxInbox::QxInbox()
+    : head_(&stub_)
+    , tail_(&stub_)
+{
+    // Intentionally left empty.
+}
+
+QxInbox::~QxInbox()
+{
+    Item item;
+    while (pop(&item)) {
+        // Release the remaining nodes.
+    }
+}
+
+void QxInbox::push(const QString &type, const QVariant &message)
+{
+    Node *node = new Node();
+    node->type = type;
+    node->message = message;
+    pushNode(node);
+}
+
+bool QxInbox::pop(Item *item)
+{
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+        if (!next) {
+            return false;
+        }
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (!next) {
+        if (tail != head_.load(std::memory_order_acquire)) {
+            // A producer has exchanged the head but not linked its node yet.
+            return false;
+        }
+
+        pushNode(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+
+        if (!next) {
+            return false;
+        }
+    }
+
+    tail_ = next;
+
+    item->type = std::move(tail->type);
+    item->message = std::move(tail->message);
+    delete tail;
+
+    return true;
+}
+
+bool QxInbox::isEmpty() const
+{
+    // The stub is the tail and the head only if no node is pushed, nor being linked.
+    return tail_ == &stub_ && head_.load(std::memory_order_acquire) == &stub_;
+}
+
+void QxInbox::pushNode(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
@@ -0,0 +1,56 @@
+#ifndef QX_INBOX_H
+#define QX_INBOX_H
+
+#include <atomic>
+#include <QString>
+#include <QVariant>
+
+/// QxInbox is a lock-free multi-producer single-consumer queue of actions with native payloads.
+/// Any thread may push(). Only the thread owning the dispatcher may pop().
+class QxInbox
+{
+public:
+    struct Item
+    {
+        // The type is interned by the consumer, so producers never take the lock of QxAtomTable.
+        QString type;
+        QVariant message;
+    };
+
+    QxInbox();
+    ~QxInbox();
+
+    QxInbox(const QxInbox &) = delete;
+    QxInbox &operator=(const QxInbox &) = delete;
+
+    /// Append an action. It is thread-safe and wait-free.
+    void push(const QString &type, const QVariant &message);
+
+    /// Take the oldest action. Returns false if the inbox is empty,
+    /// or if the next action is still being appended by another thread.
+    bool pop(Item *item);
+
+    /// Return true if nothing is pushed or being pushed. Only the consumer may call it.
+    bool isEmpty() const;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        QString type;
+        QVariant message;
+    };
+
+    void pushNode(Node *node);
+
+    // Most recently pushed node. Shared by producers.
+    std::atomic<Node *> head_;
+
+    // Oldest node. Owned by the consumer.
+    Node *tail_;
+
+    // Placeholder which keeps the list non-empty.
+    Node stub_;
+};
+
+#endif // QX_INBOX_H
@@ -6,6 +6,8 @@
 QxListener::QxListener(QObject *parent)
     : QObject{parent}
     , listener_id_(0)
+    , has_types_(false)
+    , trailing_(false)
 {
     // Intentionally left empty.
 }
@@ -20,13 +22,8 @@ void QxListener::setCallback(const QJSValue &callback)
     callback_ = callback;
 }
 
-void QxListener::dispatch(QxDispatcher *dispatcher,QString type, QJSValue message)
+void QxListener::dispatch(int atom, const QString &type, const QJSValue &message)
 {
-
-    if (wait_for_.size() > 0) {
-        dispatcher->waitFor(wait_for_);
-    }
-
     if (callback_.isCallable()) {
         QJSValueList args;
         args << type << message;
@@ -42,7 +39,7 @@ void QxListener::dispatch(QxDispatcher *dispatcher,QString type, QJSValue messag
         }
     }
 
-    emit dispatched(type,message);
+    emit dispatched(atom, type, message);
 }
 
 int QxListener::listenerId() const
@@ -60,7 +57,79 @@ QList<int> QxListener::waitFor() const
     return wait_for_;
 }
 
-void QxListener::setWaitFor(const QList<int> &wait_for)
+bool QxListener::setWaitFor(const QList<int> &wait_for)
 {
+    if (wait_for_ == wait_for) {
+        return true;
+    }
+
+    if (!dispatcher_.isNull() && !dispatcher_->acceptWaitFor(this, wait_for)) {
+        return false;
+    }
+
     wait_for_ = wait_for;
+
+    if (!dispatcher_.isNull()) {
+        dispatcher_->updateListenerWaitFor(this);
+    }
+
+    return true;
+}
+
+QxDispatcher *QxListener::dispatcher() const
+{
+    return dispatcher_;
+}
+
+void QxListener::setDispatcher(QxDispatcher *dispatcher)
+{
+    dispatcher_ = dispatcher;
+}
+
+bool QxListener::hasTypes() const
+{
+    return has_types_;
+}
+
+QList<int> QxListener::types() const
+{
+    return types_;
+}
+
+void QxListener::setTypes(const QList<int> &types)
+{
+    if (has_types_ && types_ == types) {
+        return;
+    }
+
+    has_types_ = true;
+    types_ = types;
+
+    if (!dispatcher_.isNull()) {
+        dispatcher_->updateListenerTypes(this);
+    }
+}
+
+void QxListener::clearTypes()
+{
+    if (!has_types_) {
+        return;
+    }
+
+    has_types_ = false;
+    types_.clear();
+
+    if (!dispatcher_.isNull()) {
+        dispatcher_->updateListenerTypes(this);
+    }
+}
+
+bool QxListener::isTrailing() const
+{
+    return trailing_;
+}
+
+void QxListener::setTrailing(bool trailing)
+{
+    trailing_ = trailing;
 }
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QJSValue>
+#include <QPointer>
 
 class QxDispatcher;
 
@@ -16,7 +17,7 @@ public:
 
     void setCallback(const QJSValue &callback);
 
-    void dispatch(QxDispatcher *dispatcher, QString type, QJSValue message);
+    void dispatch(int atom, const QString &type, const QJSValue &message);
 
     int listenerId() const;
 
@@ -24,15 +25,42 @@ public:
 
     QList<int> waitFor() const;
 
-    void setWaitFor(const QList<int> &wait_for);
+    /// Set the listeners to be invoked before this one. It returns false and keeps the
+    /// previous value if the dispatcher rejects it due to a cyclic dependency.
+    bool setWaitFor(const QList<int> &wait_for);
+
+    QxDispatcher *dispatcher() const;
+
+    void setDispatcher(QxDispatcher *dispatcher);
+
+    /// Return true if the listener has declared the types it is interested in.
+    bool hasTypes() const;
+
+    QList<int> types() const;
+
+    /// Declare the atoms of types this listener is interested in. The dispatcher will skip it for other types.
+    void setTypes(const QList<int> &types);
+
+    /// Withdraw the declared types. The listener will receive every message.
+    void clearTypes();
+
+    bool isTrailing() const;
+
+    /// A trailing listener is invoked after the other listeners and the native listeners,
+    /// like a receiver of the dispatched signal. It must be set before the listener is added.
+    void setTrailing(bool trailing);
 
 signals:
-    void dispatched(QString type, QJSValue message);
+    void dispatched(int atom, const QString &type, const QJSValue &message);
 
 private:
     QJSValue callback_;
     int listener_id_;
     QList<int> wait_for_;
+    QPointer<QxDispatcher> dispatcher_;
+    bool has_types_;
+    QList<int> types_;
+    bool trailing_;
 };
 
 #endif // QX_LISTENER_H
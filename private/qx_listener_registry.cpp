@@ -0,0 +1,117 @@
+#include "qx_listener_registry.h"
+
+namespace {
+
+// A listener id is made of the slot index (plus one) and the slot generation.
+// Ids stay positive, and the first generation yields the sequence 1, 2, 3 ...
+// The generation has 11 bits, so a slot serves 2048 listeners. It is then retired instead of wrapping around,
+// so a stale id never resolves to a later listener. Up to 2^20 - 1 slots may be allocated.
+constexpr int kSlotBits = 20;
+constexpr int kSlotMask = (1 << kSlotBits) - 1;
+constexpr int kGenerationMask = (1 << (31 - kSlotBits)) - 1;
+
+} // namespace
+
+QxListenerRegistry::QxListenerRegistry()
+    : next_order_(0)
+{
+    // Intentionally left empty.
+}
+
+int QxListenerRegistry::insert(QxListener *listener)
+{
+    int slot;
+
+    if (free_slots_.isEmpty()) {
+        Q_ASSERT(slots_.size() < kSlotMask);
+        slot = slots_.size();
+        slots_.append(Slot());
+    } else {
+        slot = free_slots_.takeLast();
+    }
+
+    Slot &entry = slots_[slot];
+    entry.listener = listener;
+    entry.order = next_order_++;
+    entry.used = true;
+    entry.typed = false;
+    entry.types.clear();
+    entry.trailing = false;
+
+    return slot;
+}
+
+void QxListenerRegistry::remove(int slot)
+{
+    Slot &entry = slots_[slot];
+
+    if (!entry.used) {
+        return;
+    }
+
+    entry.listener.clear();
+    entry.used = false;
+    entry.typed = false;
+    entry.types.clear();
+    entry.trailing = false;
+
+    if (entry.generation == kGenerationMask) {
+        // Retired. Its ids are all spent.
+        return;
+    }
+
+    entry.generation++;
+    free_slots_.append(slot);
+}
+
+int QxListenerRegistry::find(int id) const
+{
+    if (id <= 0) {
+        return -1;
+    }
+
+    int slot = (id & kSlotMask) - 1;
+    int generation = id >> kSlotBits;
+
+    if (slot < 0 || slot >= slots_.size()) {
+        return -1;
+    }
+
+    const Slot &entry = slots_.at(slot);
+
+    if (!entry.used || entry.generation != generation) {
+        return -1;
+    }
+
+    return slot;
+}
+
+int QxListenerRegistry::id(int slot) const
+{
+    return (slots_.at(slot).generation << kSlotBits) | (slot + 1);
+}
+
+QxListener *QxListenerRegistry::listener(int slot) const
+{
+    return slots_.at(slot).listener.data();
+}
+
+quint64 QxListenerRegistry::order(int slot) const
+{
+    return slots_.at(slot).order;
+}
+
+QxListenerRegistry::Slot &QxListenerRegistry::at(int slot)
+{
+    return slots_[slot];
+}
+
+const QxListenerRegistry::Slot &QxListenerRegistry::at(int slot) const
+{
+    return slots_.at(slot);
+}
+
+int QxListenerRegistry::capacity() const
+{
+    return slots_.size();
+}
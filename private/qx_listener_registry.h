@@ -0,0 +1,63 @@
+#ifndef QX_LISTENER_REGISTRY_H
+#define QX_LISTENER_REGISTRY_H
+
+#include <QList>
+#include <QPointer>
+
+#include "qx_listener.h"
+
+/// QxListenerRegistry is a slot map holding the listeners of a QxDispatcher.
+/// Slots are reused after removal. A listener id carries the generation of its slot,
+/// so an id of a removed listener never resolves to the listener reusing the slot.
+/// A slot whose generation is exhausted is retired rather than reused.
+class QxListenerRegistry
+{
+public:
+    struct Slot
+    {
+        QPointer<QxListener> listener;
+
+        // Registration sequence. It determines the order of delivery.
+        quint64 order = 0;
+
+        int generation = 0;
+        bool used = false;
+
+        // Normalized types the slot is indexed under. Only valid if typed is true.
+        bool typed = false;
+        QList<int> types;
+
+        // True if the listener is invoked after the native listeners.
+        bool trailing = false;
+    };
+
+    QxListenerRegistry();
+
+    /// Register a listener and return its slot.
+    int insert(QxListener *listener);
+
+    void remove(int slot);
+
+    /// Obtain the slot of a listener id. Returns -1 if the id is not registered.
+    int find(int id) const;
+
+    /// Obtain the listener id of a used slot.
+    int id(int slot) const;
+
+    QxListener *listener(int slot) const;
+
+    quint64 order(int slot) const;
+
+    Slot &at(int slot);
+    const Slot &at(int slot) const;
+
+    /// The number of slots, used or not.
+    int capacity() const;
+
+private:
+    QList<Slot> slots_;
+    QList<int> free_slots_;
+    quint64 next_order_;
+};
+
+#endif // QX_LISTENER_REGISTRY_H
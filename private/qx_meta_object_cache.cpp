@@ -0,0 +1,124 @@
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+
+#include "qx_meta_object_cache.h"
+
+namespace {
+
+struct QxMetaObjectEntry
+{
+    // The engine passed with the last value, or nullptr if none was.
+    QQmlEngine *engine = nullptr;
+    QByteArray class_name;
+    int method_count = 0;
+    QHash<QByteArray, QSharedPointer<const void>> values;
+};
+
+struct QxMetaObjectStorage
+{
+    QMutex mutex;
+
+    // Instances of a QML type share the metaobject of its property cache.
+    QHash<const QMetaObject *, QxMetaObjectEntry> entries;
+
+    // Engines whose destruction removes their entries.
+    QSet<QQmlEngine *> engines;
+};
+
+Q_GLOBAL_STATIC(QxMetaObjectStorage, metaObjectStorage)
+
+// An engine may release the metaobject of a QML type while it lives, e.g. when trimming its component cache,
+// and another type may get the same address. An entry is only used while the metaobject still matches it.
+bool matches(const QxMetaObjectEntry &entry, const QMetaObject *meta)
+{
+    return entry.method_count == meta->methodCount() && entry.class_name == meta->className();
+}
+
+void removeEngine(QQmlEngine *engine)
+{
+    QxMetaObjectStorage *storage = metaObjectStorage();
+    if (!storage) {
+        return;
+    }
+
+    QMutexLocker locker(&storage->mutex);
+
+    storage->engines.remove(engine);
+
+    for (auto iter = storage->entries.begin() ; iter != storage->entries.end() ; ) {
+        if (iter->engine == engine) {
+            iter = storage->entries.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+} // namespace
+
+void QxMetaObjectCache::removeAll(const QByteArray &prefix)
+{
+    QxMetaObjectStorage *storage = metaObjectStorage();
+    QMutexLocker locker(&storage->mutex);
+
+    for (QxMetaObjectEntry &entry : storage->entries) {
+        for (auto iter = entry.values.begin() ; iter != entry.values.end() ; ) {
+            if (iter.key().startsWith(prefix)) {
+                iter = entry.values.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+    }
+}
+
+QSharedPointer<const void> QxMetaObjectCache::find(const QMetaObject *meta, const QByteArray &key)
+{
+    QxMetaObjectStorage *storage = metaObjectStorage();
+    QMutexLocker locker(&storage->mutex);
+
+    auto iter = storage->entries.constFind(meta);
+
+    if (iter == storage->entries.constEnd() || !matches(iter.value(), meta)) {
+        return QSharedPointer<const void>();
+    }
+
+    return iter->values.value(key);
+}
+
+QSharedPointer<const void> QxMetaObjectCache::insert(const QMetaObject *meta, QQmlEngine *engine, const QByteArray &key,
+                                                     const QSharedPointer<const void> &value)
+{
+    QxMetaObjectStorage *storage = metaObjectStorage();
+    QMutexLocker locker(&storage->mutex);
+
+    QxMetaObjectEntry &entry = storage->entries[meta];
+
+    if (!matches(entry, meta)) {
+        entry = QxMetaObjectEntry();
+        entry.class_name = meta->className();
+        entry.method_count = meta->methodCount();
+    }
+
+    if (engine) {
+        entry.engine = engine;
+
+        if (!storage->engines.contains(engine)) {
+            storage->engines.insert(engine);
+            QObject::connect(engine, &QObject::destroyed, [engine]() {
+                removeEngine(engine);
+            });
+        }
+    }
+
+    auto iter = entry.values.constFind(key);
+
+    if (iter != entry.values.constEnd()) {
+        return iter.value();
+    }
+
+    entry.values.insert(key, value);
+
+    return value;
+}
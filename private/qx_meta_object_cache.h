@@ -0,0 +1,40 @@
+#ifndef QX_META_OBJECT_CACHE_H
+#define QX_META_OBJECT_CACHE_H
+
+#include <QByteArray>
+#include <QMetaObject>
+#include <QQmlEngine>
+#include <QSharedPointer>
+
+/// QxMetaObjectCache keeps values derived from a metaobject, so they are computed once per class and shared by
+/// all its instances. The entries of a QML type are removed when the engine which created it is destroyed.
+/// It is thread-safe.
+class QxMetaObjectCache
+{
+public:
+    /// Obtain the value stored under key for meta. It is created by calling create if there is none.
+    /// Pass the engine of the object if meta may describe a QML type, otherwise nullptr.
+    template <typename T, typename Create>
+    static QSharedPointer<const T> value(const QMetaObject *meta, QQmlEngine *engine, const QByteArray &key, Create create)
+    {
+        QSharedPointer<const void> result = find(meta, key);
+
+        if (result.isNull()) {
+            result = insert(meta, engine, key, QSharedPointer<const T>(create()));
+        }
+
+        return qSharedPointerCast<const T>(result);
+    }
+
+    /// Remove the values whose key starts with prefix, for all metaobjects. Holders of a value keep it.
+    static void removeAll(const QByteArray &prefix);
+
+private:
+    static QSharedPointer<const void> find(const QMetaObject *meta, const QByteArray &key);
+
+    // Store value unless another thread stored one first. Returns the stored value.
+    static QSharedPointer<const void> insert(const QMetaObject *meta, QQmlEngine *engine, const QByteArray &key,
+                                             const QSharedPointer<const void> &value);
+};
+
+#endif // QX_META_OBJECT_CACHE_H
@@ -0,0 +1,57 @@
+#include <QByteArray>
+#include <QMetaMethod>
+
+#include "qx_method_table.h"
+#include "qx_atom_table.h"
+#include "qx_meta_object_cache.h"
+
+QSharedPointer<const QxMethodTable> QxMethodTable::of(const QMetaObject *meta, const QMetaObject *base, QQmlEngine *engine)
+{
+    const QByteArray key = QByteArrayLiteral("QxMethodTable/") + base->className();
+
+    return QxMetaObjectCache::value<QxMethodTable>(meta, engine, key, [meta, base]() {
+        QSharedPointer<QxMethodTable> table = QSharedPointer<QxMethodTable>::create();
+
+        // Methods of a derived class come last, so they hide those of its bases as in QMetaObject::indexOfMethod().
+        // The internals of base, private methods and signals, e.g. property notifiers, are not filter functions.
+        // Skipping them keeps their names out of the atom table, which is never pruned.
+        for (int i = base->methodCount() ; i < meta->methodCount() ; i++) {
+            const QMetaMethod method = meta->method(i);
+
+            if (method.methodType() == QMetaMethod::Signal || method.access() == QMetaMethod::Private) {
+                continue;
+            }
+
+            Methods &methods = table->methods_[QxAtomTable::intern(QString::fromUtf8(method.name()))];
+
+            methods.named = i;
+            methods.parameter_count = method.parameterCount();
+
+            if (method.parameterCount() == 0) {
+                methods.without_message = i;
+            } else if (method.parameterCount() == 1 && method.parameterType(0) == QMetaType::QVariant) {
+                methods.with_message = i;
+            }
+        }
+
+        return table;
+    });
+}
+
+QxMethodTable::Methods QxMethodTable::methods(int atom) const
+{
+    return methods_.value(atom);
+}
+
+QList<int> QxMethodTable::atoms() const
+{
+    QList<int> atoms;
+
+    for (auto iter = methods_.constBegin() ; iter != methods_.constEnd() ; iter++) {
+        if (iter->with_message >= 0 || iter->without_message >= 0) {
+            atoms << iter.key();
+        }
+    }
+
+    return atoms;
+}
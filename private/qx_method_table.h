@@ -0,0 +1,45 @@
+#ifndef QX_METHOD_TABLE_H
+#define QX_METHOD_TABLE_H
+
+#include <QHash>
+#include <QMetaObject>
+#include <QQmlEngine>
+#include <QSharedPointer>
+
+/// QxMethodTable holds the filter functions of a class by action type. A table is built once per class, from
+/// the public and protected methods declared below a base class, e.g. QxStore, and shared by all its instances.
+/// Only their names are interned. It is never modified afterwards, so it may be read from any thread.
+class QxMethodTable
+{
+public:
+    struct Methods
+    {
+        // Index of "type(QVariant)", or -1 if there is none.
+        int with_message = -1;
+
+        // Index of "type()", or -1 if there is none.
+        int without_message = -1;
+
+        // Index of the method named type, whatever its parameters, or -1 if there is none.
+        // A QML function declaring the types of its parameters is only found by name.
+        int named = -1;
+
+        // The number of parameters of the named method.
+        int parameter_count = 0;
+    };
+
+    /// Obtain the table of the class described by meta. The methods of base and its ancestors are not filter functions.
+    /// Pass the engine of the object if it is a QML type.
+    static QSharedPointer<const QxMethodTable> of(const QMetaObject *meta, const QMetaObject *base, QQmlEngine *engine);
+
+    /// Obtain the filter functions for atom.
+    Methods methods(int atom) const;
+
+    /// Obtain the atoms with a "type(QVariant)" or "type()" function.
+    QList<int> atoms() const;
+
+private:
+    QHash<int, Methods> methods_;
+};
+
+#endif // QX_METHOD_TABLE_H
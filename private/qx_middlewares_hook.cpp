@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <QFutureWatcher>
 #include <QQmlEngine>
+#include <QQmlListReference>
 
 #include "qx_middlewares_hook.h"
 #include "quix_functions.h"
+#include "qx_atom_table.h"
+#include "../qx_middleware.h"
+#include "../qx_native_middleware.h"
 
 QxMiddlewaresHook::QxMiddlewaresHook(QObject *parent)
     : QxHook{parent}
@@ -9,84 +15,416 @@ QxMiddlewaresHook::QxMiddlewaresHook(QObject *parent)
     // Intentionally left empty.
 }
 
-void QxMiddlewaresHook::dispatch(QString type, QJSValue message)
+void QxMiddlewaresHook::dispatch(const QString &type, const QJSValue &message)
 {
     if (middlewares_.isNull()) {
         emit dispatched(type , message);
     } else {
-        next(-1, type , message);
+        invoke(0, QxAction(QxAtomTable::intern(type), message));
+    }
+}
+
+void QxMiddlewaresHook::dispatch(const QxAction &action, QJSEngine *engine)
+{
+    Q_UNUSED(engine);
+
+    if (middlewares_.isNull()) {
+        emit actionDispatched(action);
+    } else {
+        invoke(0, action);
     }
 }
 
 void QxMiddlewaresHook::setup(QQmlEngine *engine, QObject *middlewares)
 {
+    // Actions waiting for a busy middleware are passed to the new chain. Later stages hold older actions.
+    QList<QxAction> backlog;
+
+    for (auto iter = stages_.crbegin() ; iter != stages_.crend() ; iter++) {
+        if (!iter->object.isNull()) {
+            iter->object->disconnect(this);
+        }
+
+        if (!iter->flow.isNull()) {
+            backlog.append(iter->flow->backlog);
+        }
+    }
+
+    engine_ = engine;
     middlewares_ = middlewares;
-    QJSValue m_obj = engine->newQObject(middlewares);
-    QJSValue h_obj = engine->newQObject(this);
-
-    QString source = "(function (middlewares, hook) {"
-                     "  function create(senderIndex) {"
-                     "    return function (type, message) {"
-                     "      hook.next(senderIndex, type , message);"
-                     "    }"
-                     "  }"
-                     "  var data = middlewares.data;"
-                     "  for (var i = 0 ; i < data.length; i++) {"
-                     "    var m = data[i];"
-                     "    m._nextCallback = create(i);"
-                     "  }"
-                     "})";
-
-    QJSValue function = engine->evaluate(source);
-
-    QJSValueList args;
-    args << m_obj;
-    args << h_obj;
-
-    QJSValue ret = function.call(args);
-
-    if (ret.isError()) {
-        QuixFlux::printException(ret);
-    }
-
-    source = "(function (middlewares, hook) {"
-             "  return function invoke(receiverIndex, type , message) {"
-             "     if (receiverIndex >= middlewares.data.length) {"
-             "       hook.resolve(type, message);"
-             "       return;"
-             "     }"
-             "     var m = middlewares.data[receiverIndex];"
-             "     if (m.filterFunctionEnabled && m.hasOwnProperty(type) && typeof m[type] === \"function\") { "
-             "       m[type](message);"
-             "     } else if (m.hasOwnProperty(\"dispatch\") && typeof m.dispatch === \"function\") {"
-             "       m.dispatch(type, message);"
-             "     } else {"
-             "       invoke(receiverIndex + 1,type, message);"
-             "     }"
-             "  }"
-             "})";
-
-    function = engine->evaluate(source);
-    invoke_ = function.call(args);
-    if (invoke_.isError()) {
-        QuixFlux::printException(invoke_);
-    }
-}
-
-void QxMiddlewaresHook::next(int sender_index, QString type, QJSValue message)
-{
-    QJSValueList args;
-
-    args << QJSValue(sender_index + 1);
-    args << QJSValue(type);
-    args << message;
-    QJSValue result = invoke_.call(args);
+    stages_.clear();
+    plans_.clear();
+    generation_++;
+    settle_factory_ = QJSValue();
+    self_ = QJSValue();
+    emit pendingCountChanged();
+
+    if (!middlewares) {
+        // Without a chain, they are delivered.
+        for (const QxAction &action : std::as_const(backlog)) {
+            emit actionDispatched(action);
+        }
+        return;
+    }
+
+    QQmlListReference data(middlewares, "data");
+
+    for (int i = 0 ; i < data.count() ; i++) {
+        QObject *object = data.at(i);
+        Stage stage;
+        stage.object = object;
+        stage.flow.reset(new Stage::Flow);
+
+        QxNativeMiddleware *native = qobject_cast<QxNativeMiddleware *>(object);
+        QxMiddleware *middleware = qobject_cast<QxMiddleware *>(object);
+
+        if (native) {
+            native->setChain(this, i);
+            stage.native = native;
+        } else if (object) {
+            static const int dispatch_atom = QxAtomTable::intern("dispatch");
+
+            // Functions are found by name, so a QML function may declare the types of its parameters.
+            const QMetaObject *base = middleware ? &QxMiddleware::staticMetaObject : &QObject::staticMetaObject;
+            stage.filter_functions = QxMethodTable::of(object->metaObject(), base, engine);
+            stage.dispatch_method = stage.filter_functions->methods(dispatch_atom).named;
+            stage.wrapper = engine->newQObject(object);
+
+            if (stage.dispatch_method >= 0) {
+                stage.dispatch_function = stage.wrapper.property("dispatch");
+            }
+
+            if (middleware) {
+                middleware->setChain(this, i);
+                stage.middleware = middleware;
+
+                connect(middleware, SIGNAL(filterChanged()), this, SLOT(invalidate()));
+                connect(middleware, SIGNAL(typesChanged()), this, SLOT(invalidate()));
+                connect(middleware, SIGNAL(filterFunctionEnabledChanged()), this, SLOT(invalidate()));
+                middleware->setPendingCount(0);
+            }
+        }
+
+        stages_ << stage;
+    }
+
+    for (const QxAction &action : std::as_const(backlog)) {
+        invoke(0, action);
+    }
+}
+
+void QxMiddlewaresHook::next(int sender_index, const QxAction &action)
+{
+    invoke(sender_index + 1, action);
+}
+
+void QxMiddlewaresHook::next(int sender_index, const QString &type, const QJSValue &message)
+{
+    invoke(sender_index + 1, QxAction(QxAtomTable::intern(type), message));
+}
+
+void QxMiddlewaresHook::resolve(const QString &type, const QJSValue &message)
+{
+    emit actionDispatched(QxAction(QxAtomTable::intern(type), message));
+}
+
+void QxMiddlewaresHook::track(int index, const QFuture<void> &future)
+{
+    if (index < 0 || index >= stages_.size()) {
+        return;
+    }
+
+    stages_.at(index).flow->in_flight++;
+    updatePendingCount(index);
+
+    const int generation = generation_;
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, generation, index]() {
+        watcher->deleteLater();
+        settle(generation, index);
+    });
+
+    watcher->setFuture(future);
+}
+
+int QxMiddlewaresHook::pendingCount() const
+{
+    int count = 0;
+
+    for (const Stage &stage : stages_) {
+        count += stage.flow->in_flight + stage.flow->backlog.size();
+    }
+
+    return count;
+}
+
+bool QxMiddlewaresHook::hasScriptHandlers(int atom)
+{
+    const QList<int> indices = plan(atom);
+
+    // Native middlewares pass the action on as is.
+    for (int index : indices) {
+        if (stages_.at(index).native.isNull()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool QxMiddlewaresHook::handles(int atom)
+{
+    return !middlewares_.isNull() && !plan(atom).isEmpty();
+}
+
+void QxMiddlewaresHook::settle(int generation, int index)
+{
+    if (generation != generation_ || index < 0 || index >= stages_.size()) {
+        return;
+    }
+
+    Stage::Flow *flow = stages_.at(index).flow.data();
+
+    if (flow->in_flight > 0) {
+        flow->in_flight--;
+    }
+
+    updatePendingCount(index);
+    flush(index);
+}
+
+void QxMiddlewaresHook::invoke(int index, const QxAction &action)
+{
+    // Hold a copy. A handler may set up the chain again.
+    const QList<int> indices = plan(action.atom());
+
+    for (auto iter = std::lower_bound(indices.constBegin(), indices.constEnd(), index) ; iter != indices.constEnd() ; iter++) {
+        if (enter(*iter, action, false)) {
+            return;
+        }
+
+        // It has no handler for the action. Pass it on.
+    }
+
+    emit actionDispatched(action);
+}
+
+bool QxMiddlewaresHook::enter(int index, const QxAction &action, bool admitted)
+{
+    if (index < 0 || index >= stages_.size()) {
+        return false;
+    }
+
+    // Not used after the handler runs. It may set up the chain again.
+    const Stage &stage = stages_.at(index);
+
+    if (stage.object.isNull()) {
+        return false;
+    }
+
+    if (!admitted) {
+        const int limit = concurrency(stage);
+
+        // Once an action waits, later ones queue up behind it, so they do not overtake it.
+        if (!stage.flow->backlog.isEmpty() || (limit > 0 && stage.flow->in_flight >= limit)) {
+            stage.flow->backlog.enqueue(action);
+            updatePendingCount(index);
+            return true;
+        }
+    }
+
+    if (!stage.native.isNull()) {
+        stage.native->dispatch(action);
+        return true;
+    }
+
+    return invokeScript(index, stage, action);
+}
+
+void QxMiddlewaresHook::flush(int index)
+{
+    const int generation = generation_;
+
+    if (index < 0 || index >= stages_.size()) {
+        return;
+    }
+
+    // The stage is read again after each action. If a handler sets up the chain again, the generation changes.
+    while (generation == generation_) {
+        const Stage &stage = stages_.at(index);
+
+        if (stage.flow->backlog.isEmpty()) {
+            break;
+        }
+
+        const int limit = concurrency(stage);
+
+        if (limit > 0 && stage.flow->in_flight >= limit) {
+            break;
+        }
+
+        const QxAction action = stage.flow->backlog.dequeue();
+        updatePendingCount(index);
+
+        if (!enter(index, action, true)) {
+            invoke(index + 1, action);
+        }
+    }
+}
+
+int QxMiddlewaresHook::concurrency(const Stage &stage) const
+{
+    bool ordered = true;
+    int max_concurrency = 0;
+
+    if (!stage.native.isNull()) {
+        ordered = stage.native->ordered();
+        max_concurrency = stage.native->maxConcurrency();
+    } else if (!stage.middleware.isNull()) {
+        ordered = stage.middleware->ordered();
+        max_concurrency = stage.middleware->maxConcurrency();
+    }
+
+    return ordered ? 1 : qMax(max_concurrency, 0);
+}
+
+void QxMiddlewaresHook::updatePendingCount(int index)
+{
+    if (index < 0 || index >= stages_.size()) {
+        return;
+    }
+
+    const Stage &stage = stages_.at(index);
+
+    if (!stage.middleware.isNull()) {
+        stage.middleware->setPendingCount(stage.flow->in_flight + stage.flow->backlog.size());
+    }
+
+    emit pendingCountChanged();
+}
+
+bool QxMiddlewaresHook::visits(const Stage &stage, int atom) const
+{
+    if (!stage.native.isNull()) {
+        return true;
+    }
+
+    if (stage.object.isNull()) {
+        return false;
+    }
+
+    QxMiddleware *middleware = stage.middleware.data();
+
+    if (middleware && middleware->filterFunctionEnabled()) {
+        const int named = stage.filter_functions->methods(atom).named;
+
+        // The dispatch function is not a filter function of a "dispatch" action.
+        if (named >= 0 && named != stage.dispatch_method) {
+            return true;
+        }
+    }
+
+    if (stage.dispatch_method < 0) {
+        return false;
+    }
+
+    return !middleware || !middleware->hasTypes() || middleware->atoms().contains(atom);
+}
+
+QList<int> QxMiddlewaresHook::plan(int atom)
+{
+    auto iter = plans_.constFind(atom);
+
+    if (iter != plans_.constEnd()) {
+        return iter.value();
+    }
+
+    QList<int> indices;
+
+    for (int i = 0 ; i < stages_.size() ; i++) {
+        if (visits(stages_.at(i), atom)) {
+            indices << i;
+        }
+    }
+
+    plans_.insert(atom, indices);
+
+    return indices;
+}
+
+void QxMiddlewaresHook::invalidate()
+{
+    plans_.clear();
+}
+
+bool QxMiddlewaresHook::invokeScript(int index, const Stage &stage, const QxAction &action)
+{
+    const int generation = generation_;
+    QJSValue result;
+    bool handled = false;
+
+    if (!stage.middleware.isNull() && stage.middleware->filterFunctionEnabled()) {
+        const QxMethodTable::Methods methods = stage.filter_functions->methods(action.atom());
+
+        if (methods.named >= 0 && methods.named != stage.dispatch_method) {
+            // Held locally. The call may set up the chain again, which destroys the stage.
+            const QJSValue wrapper = stage.wrapper;
+            QJSValue function = wrapper.property(action.type());
+            QJSValueList args;
+
+            if (methods.parameter_count > 0) {
+                args << action.message(engine_.data());
+            }
+
+            result = function.callWithInstance(wrapper, args);
+            handled = true;
+        }
+    }
+
+    if (!handled && stage.dispatch_function.isCallable() &&
+        (stage.middleware.isNull() || !stage.middleware->hasTypes() || stage.middleware->atoms().contains(action.atom()))) {
+        const QJSValue wrapper = stage.wrapper;
+        QJSValue function = stage.dispatch_function;
+        QJSValueList args;
+        args << action.type();
+        args << action.message(engine_.data());
+        result = function.callWithInstance(wrapper, args);
+        handled = true;
+    }
+
     if (result.isError()) {
         QuixFlux::printException(result);
+    } else if (generation == generation_ && result.isObject() && result.property("then").isCallable()) {
+        await(index, result);
     }
+
+    return handled;
 }
 
-void QxMiddlewaresHook::resolve(QString type, QJSValue message)
+void QxMiddlewaresHook::await(int index, const QJSValue &thenable)
 {
-    emit dispatched(type, message);
+    if (engine_.isNull()) {
+        return;
+    }
+
+    if (settle_factory_.isUndefined()) {
+        QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
+        self_ = engine_->newQObject(this);
+        settle_factory_ = engine_->evaluate("(function (hook, generation, index) {"
+                                            "    return function () { hook.settle(generation, index); };"
+                                            "})");
+    }
+
+    QJSValue callback = settle_factory_.call(QJSValueList() << self_ << generation_ << index);
+
+    stages_.at(index).flow->in_flight++;
+    updatePendingCount(index);
+
+    // Settle on rejection too. The middleware decides whether the action goes on by calling next().
+    QJSValue result = thenable.property("then").callWithInstance(thenable, QJSValueList() << callback << callback);
+
+    if (result.isError()) {
+        QuixFlux::printException(result);
+    }
 }
@@ -1,11 +1,18 @@
 #ifndef QX_MIDDLEWARES_HOOK_H
 #define QX_MIDDLEWARES_HOOK_H
 
+#include <QFuture>
+#include <QHash>
 #include <QPointer>
+#include <QQueue>
+#include <QSharedPointer>
 
 #include "qx_hook.h"
+#include "qx_method_table.h"
 
 class QQmlEngine;
+class QxMiddleware;
+class QxNativeMiddleware;
 
 class QxMiddlewaresHook : public QxHook
 {
@@ -13,15 +20,99 @@ class QxMiddlewaresHook : public QxHook
 public:
     explicit QxMiddlewaresHook(QObject *parent = nullptr);
 
-    void dispatch(QString type, QJSValue message);
+    void dispatch(const QString &type, const QJSValue &message);
+    void dispatch(const QxAction &action, QJSEngine *engine) override;
+
+    /// Build the chain from the children of middlewares. Actions waiting for a busy middleware of the previous chain
+    /// are passed to the new one from its first middleware. Actions in flight are not tracked anymore.
     void setup(QQmlEngine *engine, QObject *middlewares);
 
+    /// Pass an action from the middleware at sender_index to the next one.
+    void next(int sender_index, const QxAction &action);
+
+    /// Keep an action in flight in the middleware at index until future finishes.
+    void track(int index, const QFuture<void> &future);
+
+    int pendingCount() const override;
+
+    bool hasScriptHandlers(int atom) override;
+
+    bool handles(int atom) override;
+
 public slots:
-    void next(int sender_index, QString type, QJSValue message);
-    void resolve(QString type, QJSValue message);
+    void next(int sender_index, const QString &type, const QJSValue &message);
+    void resolve(const QString &type, const QJSValue &message);
+
+    /// Called when an action in flight in the middleware at index has settled. It is private API. Do not use it.
+    void settle(int generation, int index);
+
+private slots:
+    void invalidate();
 
 private:
-    QJSValue invoke_;
+    // A middleware of the chain. Its handlers are resolved once, by setup().
+    struct Stage
+    {
+        QPointer<QObject> object;
+        QPointer<QxMiddleware> middleware;
+        QPointer<QxNativeMiddleware> native;
+
+        // Index of the dispatch(type, message) function, or -1 if it is not defined. It is found by name.
+        int dispatch_method = -1;
+
+        QSharedPointer<const QxMethodTable> filter_functions;
+
+        // The middleware and its dispatch function as seen by JavaScript, so a returned Promise is not converted.
+        QJSValue wrapper;
+        QJSValue dispatch_function;
+
+        // Actions in flight, and those waiting for a free slot. Shared by copies of the stage.
+        struct Flow
+        {
+            int in_flight = 0;
+            QQueue<QxAction> backlog;
+        };
+        QSharedPointer<Flow> flow;
+    };
+
+    // Pass an action to the middlewares from index on, and deliver it after the last one.
+    void invoke(int index, const QxAction &action);
+
+    // Pass an action to the middleware at index. Unless admitted is true, it waits in the backlog while the
+    // middleware is busy. Returns false if the middleware has no handler for the action.
+    bool enter(int index, const QxAction &action, bool admitted);
+
+    // Call the JavaScript handler of the middleware at index. Returns false if it has none for the action.
+    bool invokeScript(int index, const Stage &stage, const QxAction &action);
+
+    // Keep an action in flight until thenable settles.
+    void await(int index, const QJSValue &thenable);
+
+    // Admit waiting actions of the middleware at index while it has free slots.
+    void flush(int index);
+
+    // The number of actions the middleware of stage may hold in flight. 0 if unlimited.
+    int concurrency(const Stage &stage) const;
+
+    void updatePendingCount(int index);
+
+    // Return true if stage may handle a message of type atom.
+    bool visits(const Stage &stage, int atom) const;
+
+    // Obtain the indices of stages to visit for atom. Computed on demand, and dropped by invalidate().
+    QList<int> plan(int atom);
+
+    QList<Stage> stages_;
+
+    QHash<int, QList<int>> plans_;
+
+    // Incremented by setup(), so actions settling after it do not affect the new chain.
+    int generation_ = 0;
+
+    // A JavaScript function creating the callbacks passed to then(), and this hook as seen by JavaScript.
+    QJSValue settle_factory_;
+    QJSValue self_;
+    QPointer<QQmlEngine> engine_;
     QPointer<QObject> middlewares_;
 };
 
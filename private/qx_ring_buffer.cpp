@@ -0,0 +1,60 @@
+#include <cstring>
+
+#include "qx_ring_buffer.h"
+
+QxRingBuffer::QxRingBuffer(qsizetype capacity)
+    : buffer_(qMax<qsizetype>(capacity, 1), Qt::Uninitialized)
+    , data_(buffer_.data())
+    , capacity_(buffer_.size())
+    , head_(0)
+    , tail_(0)
+{
+    // Intentionally left empty.
+}
+
+qsizetype QxRingBuffer::capacity() const
+{
+    return capacity_;
+}
+
+qsizetype QxRingBuffer::size() const
+{
+    return qsizetype(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+}
+
+bool QxRingBuffer::write(const char *data, qsizetype length)
+{
+    const quint64 head = head_.load(std::memory_order_relaxed);
+    const quint64 tail = tail_.load(std::memory_order_acquire);
+
+    if (length > capacity_ - qsizetype(head - tail)) {
+        return false;
+    }
+
+    const qsizetype offset = qsizetype(head % quint64(capacity_));
+    const qsizetype first = qMin(length, capacity_ - offset);
+
+    std::memcpy(data_ + offset, data, first);
+    std::memcpy(data_, data + first, length - first);
+
+    head_.store(head + quint64(length), std::memory_order_release);
+
+    return true;
+}
+
+qsizetype QxRingBuffer::read(char *data, qsizetype max_length)
+{
+    const quint64 tail = tail_.load(std::memory_order_relaxed);
+    const quint64 head = head_.load(std::memory_order_acquire);
+
+    const qsizetype length = qMin(qsizetype(head - tail), max_length);
+    const qsizetype offset = qsizetype(tail % quint64(capacity_));
+    const qsizetype first = qMin(length, capacity_ - offset);
+
+    std::memcpy(data, data_ + offset, first);
+    std::memcpy(data + first, data_, length - first);
+
+    tail_.store(tail + quint64(length), std::memory_order_release);
+
+    return length;
+}
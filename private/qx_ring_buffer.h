@@ -0,0 +1,35 @@
+#ifndef QX_RING_BUFFER_H
+#define QX_RING_BUFFER_H
+
+#include <atomic>
+#include <QByteArray>
+
+/// QxRingBuffer is a byte ring of fixed capacity shared by one writing thread and one reading thread.
+/// Both sides are lock free. The memory is allocated once, by the constructor.
+class QxRingBuffer
+{
+public:
+    explicit QxRingBuffer(qsizetype capacity);
+
+    qsizetype capacity() const;
+
+    /// The number of bytes written and not read yet.
+    qsizetype size() const;
+
+    /// Append data. It is written entirely, or not at all if there is not enough free space. Call it from the writing thread.
+    bool write(const char *data, qsizetype length);
+
+    /// Move up to max_length bytes to data. Returns the number of bytes read. Call it from the reading thread.
+    qsizetype read(char *data, qsizetype max_length);
+
+private:
+    QByteArray buffer_;
+    char *data_;
+    qsizetype capacity_;
+
+    // Total bytes written and read. Their difference is the size, and their remainder the offsets in buffer_.
+    std::atomic<quint64> head_;
+    std::atomic<quint64> tail_;
+};
+
+#endif // QX_RING_BUFFER_H
@@ -1,7 +1,108 @@
 #include <QtDebug>
+#include <QHash>
+#include <QMetaMethod>
 #include <QMetaObject>
+#include <QMutex>
 
 #include "qx_signal_proxy.h"
+#include "qx_atom_table.h"
+#include "qx_meta_object_cache.h"
+
+namespace {
+
+// Key of the descriptors in QxMetaObjectCache. The method offset is appended.
+const QByteArray DescriptorsKey = QByteArrayLiteral("QxSignalProxy:");
+
+struct QxSignalCache
+{
+    QMutex mutex;
+    // Keyed by type id, as the name of a type may be spelled differently in a signature.
+    QHash<int, QxSignalConverter> converters;
+};
+
+Q_GLOBAL_STATIC(QxSignalCache, signalCache)
+
+QxSignalParameter createParameter(const QMetaMethod &method, int index, const QxSignalCache *cache)
+{
+    QxSignalParameter parameter;
+    parameter.name = QString(method.parameterNames().at(index));
+    parameter.type = method.parameterMetaType(index).id();
+
+    auto converter = cache->converters.constFind(parameter.type);
+
+    if (converter != cache->converters.constEnd()) {
+        parameter.kind = QxSignalParameter::Converted;
+        parameter.converter = converter.value();
+        return parameter;
+    }
+
+    switch (parameter.type) {
+    case QMetaType::Bool:
+        parameter.kind = QxSignalParameter::Bool;
+        break;
+    case QMetaType::Int:
+        parameter.kind = QxSignalParameter::Int;
+        break;
+    case QMetaType::UInt:
+        parameter.kind = QxSignalParameter::UInt;
+        break;
+    case QMetaType::Double:
+        parameter.kind = QxSignalParameter::Double;
+        break;
+    case QMetaType::QString:
+        parameter.kind = QxSignalParameter::String;
+        break;
+    case QMetaType::QVariant:
+        parameter.kind = QxSignalParameter::Variant;
+        break;
+    default:
+        if (parameter.type == qMetaTypeId<QJSValue>()) {
+            parameter.kind = QxSignalParameter::ScriptValue;
+        } else if (QMetaType::isRegistered(parameter.type)) {
+            parameter.kind = QxSignalParameter::Generic;
+        } else {
+            qWarning() << "QxSignalProxy: Unhandled parameter type:" << method.parameterTypeName(index)
+                       << "- Register a converter with QxActionCreator::registerConverter().";
+        }
+        break;
+    }
+
+    return parameter;
+}
+
+QSharedPointer<const QxSignalDescriptorList> createDescriptors(const QMetaObject *meta, int method_offset, QxSignalCache *cache)
+{
+    QMutexLocker locker(&cache->mutex);
+
+    QSharedPointer<QxSignalDescriptorList> result = QSharedPointer<QxSignalDescriptorList>::create();
+
+    const int count = meta->methodCount();
+
+    for (int i = method_offset ; i < count ; i++) {
+        QMetaMethod method = meta->method(i);
+
+        if (method.methodType() != QMetaMethod::Signal) {
+            continue;
+        }
+
+        QxSignalDescriptor descriptor;
+        descriptor.signal_index = i;
+        descriptor.atom = QxAtomTable::intern(QString(method.name()));
+
+        // The canonical string, so the dispatcher recognizes it by identity.
+        descriptor.type = QxAtomTable::name(descriptor.atom);
+
+        for (int j = 0 ; j < method.parameterCount() ; j++) {
+            descriptor.parameters << createParameter(method, j, cache);
+        }
+
+        result->append(descriptor);
+    }
+
+    return result;
+}
+
+} // namespace
 
 QxSignalProxy::QxSignalProxy(QObject *parent)
     : QObject{parent}
@@ -9,25 +110,18 @@ QxSignalProxy::QxSignalProxy(QObject *parent)
     // Intentionally left empty.
 }
 
-void QxSignalProxy::bind(QObject *source, int signal_index, QQmlEngine *engine, QxDispatcher *dispatcher)
+void QxSignalProxy::bind(QObject *source, int method_offset, QQmlEngine *engine, QxDispatcher *dispatcher)
 {
     const int member_offset = QObject::staticMetaObject.methodCount();
 
-    QMetaMethod method = source->metaObject()->method(signal_index);
-
-    parameter_types_ = QVector<int>(method.parameterCount());
-    parameter_names_ = QVector<QString>(method.parameterCount());
-    type = method.name();
+    descriptors_ = descriptors(source->metaObject(), method_offset, engine);
     engine_ = engine;
     dispatcher_ = dispatcher;
 
-    for (int i = 0 ; i < method.parameterCount() ; i++) {
-        parameter_types_[i] = method.parameterType(i);
-        parameter_names_[i] = QString(method.parameterNames().at(i));
-    }
-
-    if (!QMetaObject::connect(source, signal_index, this, member_offset, Qt::AutoConnection, 0)) {
-        qWarning() << "Failed to bind signal";
+    for (int i = 0 ; i < descriptors_->size() ; i++) {
+        if (!QMetaObject::connect(source, descriptors_->at(i).signal_index, this, member_offset + i, Qt::AutoConnection, 0)) {
+            qWarning() << "Failed to bind signal";
+        }
     }
 }
 
@@ -35,35 +129,15 @@ int QxSignalProxy::qt_metacall(QMetaObject::Call _c, int _id, void **_a)
 {
     int method_id = QObject::qt_metacall(_c, _id, _a);
 
-    if (method_id < 0) {
+    if (method_id < 0 || descriptors_.isNull()) {
         return method_id;
     }
 
     if (_c == QMetaObject::InvokeMetaMethod) {
-
-        if (method_id == 0) {
-            QVariantMap message;
-
-            for (int i = 0 ; i < parameter_types_.count() ; i++) {
-                const int type_id = parameter_types_.at(i);
-                QVariant v;
-
-                // Extract parameter value based on its type
-                if (type_id == QMetaType::QVariant) {
-                    v = *reinterpret_cast<QVariant *>(_a[i + 1]);
-                } else if (QMetaType::isRegistered(type_id)) {
-                    v= QVariant(QMetaType(type_id), _a[i + 1]);
-                } else {
-                    qWarning() << "QxSignalProxy: Unhandled parameter type:" << type_id;
-                    continue;
-                }
-
-                message[parameter_names_.at(i)] = v;
-            }
-
-            dispatch(message);
+        if (method_id < descriptors_->size()) {
+            dispatch(descriptors_->at(method_id), _a);
         }
-        method_id--;
+        method_id -= descriptors_->size();
     }
 
     return method_id;
@@ -79,20 +153,101 @@ void QxSignalProxy::setDispatcher(QxDispatcher *dispatcher)
     dispatcher_ = dispatcher;
 }
 
-void QxSignalProxy::dispatch(const QVariantMap &message)
+QSharedPointer<const QxSignalDescriptorList> QxSignalProxy::descriptors(const QMetaObject *meta, int method_offset, QQmlEngine *engine)
+{
+    return QxMetaObjectCache::value<QxSignalDescriptorList>(meta, engine, DescriptorsKey + QByteArray::number(method_offset), [meta, method_offset]() {
+        return createDescriptors(meta, method_offset, signalCache());
+    });
+}
+
+void QxSignalProxy::registerConverter(QMetaType type, QxSignalConverter converter)
+{
+    QxSignalCache *cache = signalCache();
+    QMutexLocker locker(&cache->mutex);
+
+    cache->converters.insert(type.id(), converter);
+    locker.unlock();
+
+    // Descriptors are rebuilt on the next bind. Bound proxies keep the ones they hold.
+    QxMetaObjectCache::removeAll(DescriptorsKey);
+}
+
+void QxSignalProxy::dispatch(const QxSignalDescriptor &descriptor, void **_a)
 {
     if (engine_.isNull() || dispatcher_.isNull()) {
         return;
     }
 
-    QJSValue value = engine_->newObject();
+    if (!dispatcher_->hasScriptListeners(descriptor.atom)) {
+        // Only C++ receives it. The message is converted later if that changes before delivery.
+        QVariantMap message;
 
-    QMapIterator<QString, QVariant> iter(message);
-    while (iter.hasNext()) {
-        iter.next();
-        QJSValue v = engine_->toScriptValue<QVariant>(iter.value());
-        value.setProperty(iter.key(), v);
+        for (int i = 0 ; i < descriptor.parameters.size() ; i++) {
+            const QxSignalParameter &parameter = descriptor.parameters.at(i);
+            if (parameter.kind != QxSignalParameter::Unsupported) {
+                message.insert(parameter.name, variant(parameter, _a[i + 1]));
+            }
+        }
+
+        dispatcher_->dispatch(descriptor.type, QVariant(message));
+        return;
+    }
+
+    // Properties are always set in the order of parameters, so messages of a signal share a shape.
+    QJSValue message = engine_->newObject();
+
+    for (int i = 0 ; i < descriptor.parameters.size() ; i++) {
+        const QxSignalParameter &parameter = descriptor.parameters.at(i);
+        if (parameter.kind != QxSignalParameter::Unsupported) {
+            message.setProperty(parameter.name, scriptValue(parameter, _a[i + 1]));
+        }
     }
 
-    dispatcher_->dispatch(type, value);
+    dispatcher_->dispatch(descriptor.type, message);
+}
+
+QJSValue QxSignalProxy::scriptValue(const QxSignalParameter &parameter, void *argument) const
+{
+    switch (parameter.kind) {
+    case QxSignalParameter::Bool:
+        return QJSValue(*reinterpret_cast<bool *>(argument));
+    case QxSignalParameter::Int:
+        return QJSValue(*reinterpret_cast<int *>(argument));
+    case QxSignalParameter::UInt:
+        return QJSValue(*reinterpret_cast<uint *>(argument));
+    case QxSignalParameter::Double:
+        return QJSValue(*reinterpret_cast<double *>(argument));
+    case QxSignalParameter::String:
+        return QJSValue(*reinterpret_cast<QString *>(argument));
+    case QxSignalParameter::ScriptValue:
+        return *reinterpret_cast<QJSValue *>(argument);
+    default:
+        return engine_->toScriptValue<QVariant>(variant(parameter, argument));
+    }
+}
+
+QVariant QxSignalProxy::variant(const QxSignalParameter &parameter, void *argument)
+{
+    switch (parameter.kind) {
+    case QxSignalParameter::Bool:
+        return QVariant(*reinterpret_cast<bool *>(argument));
+    case QxSignalParameter::Int:
+        return QVariant(*reinterpret_cast<int *>(argument));
+    case QxSignalParameter::UInt:
+        return QVariant(*reinterpret_cast<uint *>(argument));
+    case QxSignalParameter::Double:
+        return QVariant(*reinterpret_cast<double *>(argument));
+    case QxSignalParameter::String:
+        return QVariant(*reinterpret_cast<QString *>(argument));
+    case QxSignalParameter::ScriptValue:
+        return reinterpret_cast<QJSValue *>(argument)->toVariant();
+    case QxSignalParameter::Variant:
+        return *reinterpret_cast<QVariant *>(argument);
+    case QxSignalParameter::Converted:
+        return parameter.converter(argument);
+    case QxSignalParameter::Generic:
+        return QVariant(QMetaType(parameter.type), argument);
+    default:
+        return QVariant();
+    }
 }
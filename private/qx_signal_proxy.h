@@ -1,16 +1,57 @@
 #ifndef QX_SIGNAL_PROXY_H
 #define QX_SIGNAL_PROXY_H
 
+#include <functional>
+#include <QSharedPointer>
 #include <QVector>
 
 #include "../qx_dispatcher.h"
 
+/// A signal argument converter for types which QVariant can't carry as is.
+using QxSignalConverter = std::function<QVariant(const void *argument)>;
+
+/// A parameter of a signal. The conversion is chosen once, from its type.
+struct QxSignalParameter
+{
+    enum Kind {
+        Bool,
+        Int,
+        UInt,
+        Double,
+        String,
+        ScriptValue,
+        Variant,
+        Converted,
+        Generic,
+        Unsupported
+    };
+
+    QString name;
+    int type = QMetaType::UnknownType;
+    Kind kind = Unsupported;
+    QxSignalConverter converter;
+};
+
+/// The parameters of a signal which is converted to an action.
+struct QxSignalDescriptor
+{
+    int signal_index = -1;
+    int atom = 0;
+    QString type;
+    QVector<QxSignalParameter> parameters;
+};
+
+using QxSignalDescriptorList = QVector<QxSignalDescriptor>;
+
+/// QxSignalProxy converts the signals of an object to actions. A single proxy serves all the signals
+/// of its source. Each signal is connected to its own dynamic method index, which selects the descriptor.
 class QxSignalProxy : public QObject
 {
 public:
     explicit QxSignalProxy(QObject *parent = nullptr);
 
-    void bind(QObject *source, int signal_index, QQmlEngine *engine, QxDispatcher *dispatcher);
+    /// Connect the signals of source declared from method_offset on.
+    void bind(QObject *source, int method_offset, QQmlEngine *engine, QxDispatcher *dispatcher);
 
     int qt_metacall(QMetaObject::Call _c, int _id, void **_a);
 
@@ -18,12 +59,21 @@ public:
 
     void setDispatcher(QxDispatcher *dispatcher);
 
+    /// Obtain the descriptors of signals in meta declared from method_offset on.
+    /// They are computed once per class and shared by all its instances, until engine is destroyed.
+    static QSharedPointer<const QxSignalDescriptorList> descriptors(const QMetaObject *meta, int method_offset, QQmlEngine *engine);
+
+    /// Register a converter for arguments of type. Classes bound afterwards use it.
+    static void registerConverter(QMetaType type, QxSignalConverter converter);
+
 private:
-    void dispatch(const QVariantMap &message);
+    void dispatch(const QxSignalDescriptor &descriptor, void **_a);
 
-    QString type;
-    QVector<int> parameter_types_;
-    QVector<QString> parameter_names_;
+    QJSValue scriptValue(const QxSignalParameter &parameter, void *argument) const;
+
+    static QVariant variant(const QxSignalParameter &parameter, void *argument);
+
+    QSharedPointer<const QxSignalDescriptorList> descriptors_;
     QPointer<QQmlEngine> engine_;
     QPointer<QxDispatcher> dispatcher_;
 };
@@ -0,0 +1,101 @@
+#include <QThreadStorage>
+#include <QTimerEvent>
+
+#include "qx_timer_service.h"
+
+QxTimerService::QxTimerService(QObject *parent)
+    : QObject{parent}
+    , armed_deadline_(-1)
+    , next_id_(1)
+{
+    clock_.start();
+}
+
+QxTimerService *QxTimerService::instance()
+{
+    static QThreadStorage<QxTimerService *> services;
+
+    if (!services.hasLocalData()) {
+        services.setLocalData(new QxTimerService);
+    }
+
+    return services.localData();
+}
+
+int QxTimerService::start(int msecs, QObject *receiver, Callback callback)
+{
+    const int id = next_id_++;
+    const qint64 deadline = clock_.elapsed() + qMax(msecs, 0);
+
+    entries_.insert(id, Entry{deadline, receiver, std::move(callback)});
+    deadlines_.insert(deadline, id);
+
+    if (!timer_.isActive() || deadline < armed_deadline_) {
+        rearm();
+    }
+
+    return id;
+}
+
+void QxTimerService::stop(int id)
+{
+    auto iter = entries_.find(id);
+
+    if (iter == entries_.end()) {
+        return;
+    }
+
+    deadlines_.remove(iter->deadline, id);
+    entries_.erase(iter);
+
+    // A timer left running for a removed deadline fires once and is rearmed then.
+    if (deadlines_.isEmpty()) {
+        rearm();
+    }
+}
+
+void QxTimerService::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != timer_.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    const qint64 now = clock_.elapsed();
+    QList<int> due;
+
+    while (!deadlines_.isEmpty() && deadlines_.firstKey() <= now) {
+        due << deadlines_.first();
+        deadlines_.erase(deadlines_.begin());
+    }
+
+    rearm();
+
+    // Callbacks may start or stop other entries, including those due now.
+    for (int id : std::as_const(due)) {
+        auto iter = entries_.find(id);
+
+        if (iter == entries_.end()) {
+            continue;
+        }
+
+        const Entry entry = iter.value();
+        entries_.erase(iter);
+
+        if (!entry.receiver.isNull()) {
+            entry.callback();
+        }
+    }
+}
+
+void QxTimerService::rearm()
+{
+    if (deadlines_.isEmpty()) {
+        timer_.stop();
+        armed_deadline_ = -1;
+        return;
+    }
+
+    armed_deadline_ = deadlines_.firstKey();
+    timer_.start(qMax<qint64>(armed_deadline_ - clock_.elapsed(), 0), Qt::PreciseTimer, this);
+}
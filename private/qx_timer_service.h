@@ -0,0 +1,58 @@
+#ifndef QX_TIMER_SERVICE_H
+#define QX_TIMER_SERVICE_H
+
+#include <functional>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMultiMap>
+#include <QObject>
+#include <QPointer>
+
+/// QxTimerService runs one-shot callbacks on a single timer per thread.
+/// It is shared by native middlewares, so they do not need a QTimer per instance.
+class QxTimerService : public QObject
+{
+    Q_OBJECT
+public:
+    using Callback = std::function<void()>;
+
+    /// Obtain the service of the current thread. It is created on first access.
+    static QxTimerService *instance();
+
+    /// Run callback once after msecs. It is skipped if receiver is destroyed before. Returns an id for stop().
+    int start(int msecs, QObject *receiver, Callback callback);
+
+    void stop(int id);
+
+protected:
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    explicit QxTimerService(QObject *parent = nullptr);
+
+    // Start the timer for the earliest deadline, or stop it if there is none.
+    void rearm();
+
+    struct Entry
+    {
+        qint64 deadline;
+        QPointer<QObject> receiver;
+        Callback callback;
+    };
+
+    QElapsedTimer clock_;
+    QBasicTimer timer_;
+
+    // The deadline the timer is started for, or -1.
+    qint64 armed_deadline_;
+
+    QHash<int, Entry> entries_;
+
+    // Ids of entries, ordered by deadline.
+    QMultiMap<qint64, int> deadlines_;
+
+    int next_id_;
+};
+
+#endif // QX_TIMER_SERVICE_H
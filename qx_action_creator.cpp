@@ -43,6 +43,7 @@
 
 QxActionCreator::QxActionCreator(QObject *parent)
     : QObject{parent}
+    , proxy_(nullptr)
 {
     // Intentionally left empty.
 }
@@ -69,8 +70,8 @@ QxDispatcher *QxActionCreator::dispatcher() const
 void QxActionCreator::setDispatcher(QxDispatcher *value)
 {
     dispatcher_ = value;
-    for (int i = 0 ; i < proxy_list_.size();i++) {
-        proxy_list_[i]->setDispatcher(dispatcher_);
+    if (proxy_) {
+        proxy_->setDispatcher(dispatcher_);
     }
 
     emit dispatcherChanged();
@@ -88,20 +89,13 @@ QString QxActionCreator::genKeyTable()
 
     footer <<  "}";
 
-    const int member_offset = QObject::staticMetaObject.methodCount();
+    // Signals declared by QxActionCreator itself are not actions.
+    const int member_offset = QxActionCreator::staticMetaObject.methodCount();
 
-    const QMetaObject *meta = metaObject();
+    const auto descriptors = QxSignalProxy::descriptors(metaObject(), member_offset, qmlEngine(this));
 
-    int count = meta->methodCount();
-
-    for (int i = member_offset ; i < count ;i++) {
-        QMetaMethod method = meta->method(i);
-        if (method.name() == "dispatcherChanged") {
-            continue;
-        }
-        if (method.methodType() == QMetaMethod::Signal) {
-            properties << QString("    property string %1;\n").arg(QString(method.name()));
-        }
+    for (const QxSignalDescriptor &descriptor : *descriptors) {
+        properties << QString("    property string %1;\n").arg(descriptor.type);
     }
 
     QStringList content;
@@ -117,6 +111,18 @@ void QxActionCreator::dispatch(QString type, QJSValue message)
     }
 }
 
+/*! \fn template <typename T> void QxActionCreator::registerConverter(std::function<QVariant(const T &)> converter)
+
+    Register a \a converter for signal arguments of type T, which is not supported by QVariant as is.
+    Without a converter, such an argument is left out of the message. Register it before creators are completed.
+
+    \code
+    QxActionCreator::registerConverter<Money>([](const Money &money) {
+        return QVariantMap{{"amount", money.amount()}, {"currency", money.currency()}};
+    });
+    \endcode
+ */
+
 void QxActionCreator::classBegin()
 {
     // Intentionally left empty.
@@ -130,26 +136,11 @@ void QxActionCreator::componentComplete()
         setDispatcher(qobject_cast<QxDispatcher *>(QxAppDispatcher::instance(engine)));
     }
 
-    QxDispatcher *dispatcher = dispatcher_.data();
-
-    const int member_offset = QObject::staticMetaObject.methodCount();
-
-    const QMetaObject *meta = metaObject();
-
-    int count = meta->methodCount();
+    // Signals declared by QxActionCreator itself are not actions.
+    const int member_offset = QxActionCreator::staticMetaObject.methodCount();
 
-    for (int i = member_offset ; i < count ;i++) {
-        QMetaMethod method = meta->method(i);
-        if (method.name() == "dispatcherChanged") {
-            continue;
-        }
-
-        if (method.methodType() == QMetaMethod::Signal) {
-            QxSignalProxy *proxy = new QxSignalProxy(this);
-            proxy->bind(this, i, engine, dispatcher);
-            proxy_list_ << proxy;
-        }
-    }
+    proxy_ = new QxSignalProxy(this);
+    proxy_->bind(this, member_offset, engine, dispatcher_.data());
 }
 
 
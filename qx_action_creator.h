@@ -4,8 +4,7 @@
 #include <QQmlParserStatus>
 
 #include "qx_app_dispatcher.h"
-
-class QxSignalProxy;
+#include "private/qx_signal_proxy.h"
 
 class QxActionCreator : public QObject, public QQmlParserStatus
 {
@@ -19,6 +18,15 @@ public:
     QxDispatcher *dispatcher() const;
     void setDispatcher(QxDispatcher *value);
 
+    /// Register a converter for signal arguments of type T, which is used by creators completed afterwards.
+    template <typename T>
+    static void registerConverter(std::function<QVariant(const T &)> converter)
+    {
+        QxSignalProxy::registerConverter(QMetaType::fromType<T>(), [converter](const void *argument) {
+            return converter(*reinterpret_cast<const T *>(argument));
+        });
+    }
+
 public slots:
     QString genKeyTable();
     void dispatch(QString type, QJSValue message = QJSValue());
@@ -29,7 +37,7 @@ protected:
 
 private:
     QPointer<QxDispatcher> dispatcher_;
-    QList<QxSignalProxy *> proxy_list_;
+    QxSignalProxy *proxy_;
 
 signals:
     void dispatcherChanged();
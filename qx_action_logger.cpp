@@ -0,0 +1,449 @@
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QFile>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QUrl>
+#include <QtEndian>
+
+#include "qx_action_logger.h"
+#include "qx_app_dispatcher.h"
+#include "private/qx_atom_table.h"
+
+namespace {
+
+// Size of a record header: length (quint32), kind (quint8), sequence (quint64), timestamp (qint64) and atom (qint32).
+const qsizetype RecordHeaderSize = 4 + 1 + 8 + 8 + 4;
+
+const qsizetype MinimumBufferSize = 4096;
+
+// How often the writer thread looks for records if it is not woken up.
+const int FlushInterval = 100;
+
+// Scratch memory kept between records. A larger buffer, grown by a large message, is released after use.
+const qsizetype ScratchRetainSize = 64 * 1024;
+
+// Appends to a byte array up to a limit. Writes beyond it fail, so a message which could never fit in the
+// ring is not encoded in full.
+class BoundedWriter : public QIODevice
+{
+public:
+    BoundedWriter(QByteArray *data, qsizetype limit)
+        : data_(data)
+        , limit_(limit)
+        , overflowed_(false)
+    {
+        open(QIODevice::WriteOnly);
+    }
+
+    bool overflowed() const
+    {
+        return overflowed_;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 max_length) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(max_length);
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 length) override
+    {
+        if (overflowed_ || data_->size() + length > limit_) {
+            overflowed_ = true;
+            return -1;
+        }
+
+        data_->append(data, length);
+        return length;
+    }
+
+private:
+    QByteArray *data_;
+    qsizetype limit_;
+    bool overflowed_;
+};
+
+}
+
+/*!
+    \qmltype QxActionLogger
+    \inqmlmodule QuixFlux
+    \brief Record dispatched actions to a binary file
+
+    \code
+        import QuixFlux
+    \endcode
+
+    QxActionLogger records every action delivered by a dispatcher, without calling into JavaScript.
+    It is registered as a native listener, encodes each action into a compact binary record,
+    and appends it to a ring buffer allocated up front. A background thread writes the buffer to fileName.
+
+    Memory use is bounded by bufferSize. If the writer falls behind and the buffer is full, records are dropped
+    and counted by droppedCount. Sequence numbers keep counting, so a reader could locate the gaps.
+
+    \code
+        QxActionLogger {
+            fileName: StandardPaths.writableLocation(StandardPaths.AppDataLocation) + "/actions.log"
+            bufferSize: 4 * 1024 * 1024
+        }
+    \endcode
+
+    The file starts with the bytes "QXLG" and the format version as a little endian quint32.
+    Records follow, each with a little endian header:
+
+    \list
+        \li quint32 - the size of the record, including the header
+        \li quint8 - the kind: 0 for a type, 1 for an action
+        \li quint64 - the sequence number of the action
+        \li qint64 - the monotonic time in nanoseconds since logging started
+        \li qint32 - the type atom
+    \endlist
+
+    The body of a type record is the name of the atom in UTF-8. It precedes the first action of the type.
+    The body of an action record is the message encoded as CBOR.
+ */
+
+QxActionLogger::QxActionLogger(QObject *parent)
+    : QObject{parent}
+    , completed_(false)
+    , buffer_size_(1024 * 1024)
+    , enabled_(true)
+    , listener_id_(-1)
+    , writer_(nullptr)
+    , stopping_(false)
+    , wake_requested_(false)
+    , sequence_(0)
+    , dropped_count_(0)
+{
+    // Intentionally left empty.
+}
+
+QxActionLogger::~QxActionLogger()
+{
+    stop();
+}
+
+/*! \qmlproperty object QxActionLogger::dispatcher
+    The dispatcher to record. The default value is QxAppDispatcher.
+ */
+
+QObject *QxActionLogger::dispatcher() const
+{
+    return dispatcher_.data();
+}
+
+void QxActionLogger::setDispatcher(QObject *dispatcher)
+{
+    QxDispatcher *value = qobject_cast<QxDispatcher *>(dispatcher);
+
+    if (dispatcher && !value) {
+        qWarning() << "QxActionLogger: dispatcher is not a QxDispatcher";
+    }
+
+    if (dispatcher_.data() == value) {
+        return;
+    }
+
+    dispatcher_ = value;
+    restart();
+    emit dispatcherChanged();
+}
+
+/*! \qmlproperty string QxActionLogger::fileName
+    The file to write. It is truncated when logging starts. A "file:" URL is accepted.
+ */
+
+QString QxActionLogger::fileName() const
+{
+    return file_name_;
+}
+
+void QxActionLogger::setFileName(const QString &file_name)
+{
+    if (file_name_ == file_name) {
+        return;
+    }
+
+    file_name_ = file_name;
+    restart();
+    emit fileNameChanged();
+}
+
+/*! \qmlproperty array QxActionLogger::types
+    The types to record. If it is empty, every action is recorded.
+ */
+
+QStringList QxActionLogger::types() const
+{
+    return types_;
+}
+
+void QxActionLogger::setTypes(const QStringList &types)
+{
+    if (types_ == types) {
+        return;
+    }
+
+    types_ = types;
+    restart();
+    emit typesChanged();
+}
+
+/*! \qmlproperty int QxActionLogger::bufferSize
+    The size of the ring buffer in bytes. It is the memory budget of the logger. The default value is 1 MiB.
+    The minimum is 4096 bytes. A smaller value is raised to it.
+
+    A record larger than the buffer is dropped and counted by droppedCount.
+ */
+
+int QxActionLogger::bufferSize() const
+{
+    return buffer_size_;
+}
+
+void QxActionLogger::setBufferSize(int buffer_size)
+{
+    if (buffer_size_ == buffer_size) {
+        return;
+    }
+
+    buffer_size_ = buffer_size;
+    restart();
+    emit bufferSizeChanged();
+}
+
+/*! \qmlproperty bool QxActionLogger::enabled
+    Set it to false to stop logging. The default value is true.
+ */
+
+bool QxActionLogger::enabled() const
+{
+    return enabled_;
+}
+
+void QxActionLogger::setEnabled(bool enabled)
+{
+    if (enabled_ == enabled) {
+        return;
+    }
+
+    enabled_ = enabled;
+    restart();
+    emit enabledChanged();
+}
+
+/*! \qmlproperty int QxActionLogger::droppedCount
+    The number of records dropped because the buffer was full. It is reset when logging starts again.
+ */
+
+int QxActionLogger::droppedCount() const
+{
+    return dropped_count_.load(std::memory_order_relaxed);
+}
+
+/*! \qmlmethod QxActionLogger::flush()
+    Ask the writer thread to write the buffered records now, instead of on its next round.
+ */
+
+void QxActionLogger::flush()
+{
+    QMutexLocker locker(&mutex_);
+    wake_.wakeOne();
+}
+
+void QxActionLogger::classBegin()
+{
+    // Intentionally left empty.
+}
+
+void QxActionLogger::componentComplete()
+{
+    completed_ = true;
+
+    if (dispatcher_.isNull()) {
+        QQmlEngine *engine = qmlEngine(this);
+        dispatcher_ = engine ? QxAppDispatcher::instance(engine) : nullptr;
+
+        if (dispatcher_.isNull()) {
+            qWarning() << "Unknown error: Unable to access QxAppDispatcher";
+        } else {
+            emit dispatcherChanged();
+        }
+    }
+
+    restart();
+}
+
+void QxActionLogger::restart()
+{
+    stop();
+
+    if (completed_ && enabled_ && !dispatcher_.isNull() && !file_name_.isEmpty()) {
+        start();
+    }
+}
+
+void QxActionLogger::start()
+{
+    const QUrl url(file_name_);
+    const QString file_name = url.isLocalFile() ? url.toLocalFile() : file_name_;
+
+    ring_.reset(new QxRingBuffer(qMax<qsizetype>(buffer_size_, MinimumBufferSize)));
+    known_atoms_.clear();
+    sequence_ = 0;
+    stopping_ = false;
+    wake_requested_ = false;
+    clock_.start();
+
+    if (dropped_count_.exchange(0) != 0) {
+        emit droppedCountChanged();
+    }
+
+    writer_ = QThread::create([this, file_name]() {
+        writeLoop(file_name);
+    });
+    writer_->start(QThread::LowPriority);
+
+    QPointer<QxActionLogger> guard(this);
+    listener_id_ = dispatcher_->addNativeListener(types_, [guard](const QString &type, const QVariant &message) {
+        if (!guard.isNull()) {
+            guard->record(type, message);
+        }
+    });
+}
+
+void QxActionLogger::stop()
+{
+    if (listener_id_ >= 0) {
+        if (!dispatcher_.isNull()) {
+            dispatcher_->removeNativeListener(listener_id_);
+        }
+        listener_id_ = -1;
+    }
+
+    if (writer_) {
+        {
+            QMutexLocker locker(&mutex_);
+            stopping_ = true;
+            wake_.wakeOne();
+        }
+
+        writer_->wait();
+        delete writer_;
+        writer_ = nullptr;
+    }
+
+    ring_.reset();
+}
+
+void QxActionLogger::record(const QString &type, const QVariant &message)
+{
+    if (ring_.isNull()) {
+        return;
+    }
+
+    const int atom = QxAtomTable::intern(type);
+    const quint64 sequence = ++sequence_;
+    const qint64 timestamp = clock_.nsecsElapsed();
+
+    if (!known_atoms_.contains(atom)) {
+        scratch_.resize(RecordHeaderSize);
+        scratch_.append(type.toUtf8());
+
+        if (!commit(TypeRecord, sequence, timestamp, atom)) {
+            return;
+        }
+
+        known_atoms_.insert(atom);
+    }
+
+    scratch_.resize(RecordHeaderSize);
+
+    BoundedWriter device(&scratch_, ring_->capacity());
+    {
+        QCborStreamWriter writer(&device);
+        QCborValue::fromVariant(message).toCbor(writer);
+    }
+
+    if (device.overflowed()) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        emit droppedCountChanged();
+    } else {
+        commit(ActionRecord, sequence, timestamp, atom);
+    }
+
+    if (scratch_.capacity() > ScratchRetainSize) {
+        // Release the memory grown by a large message.
+        scratch_.clear();
+    }
+
+    // Wake the writer early if the buffer is filling up, instead of waiting for its next round.
+    // The dispatcher never takes the mutex here. If the writer is about to wait, it wakes up by its timeout.
+    if (ring_->size() > ring_->capacity() / 2 && !wake_requested_.exchange(true, std::memory_order_acq_rel)) {
+        wake_.wakeOne();
+    }
+}
+
+bool QxActionLogger::commit(RecordKind kind, quint64 sequence, qint64 timestamp, int atom)
+{
+    char *header = scratch_.data();
+
+    qToLittleEndian<quint32>(quint32(scratch_.size()), header);
+    header[4] = char(kind);
+    qToLittleEndian<quint64>(sequence, header + 5);
+    qToLittleEndian<qint64>(timestamp, header + 13);
+    qToLittleEndian<qint32>(atom, header + 21);
+
+    if (!ring_->write(scratch_.constData(), scratch_.size())) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        emit droppedCountChanged();
+        return false;
+    }
+
+    return true;
+}
+
+void QxActionLogger::writeLoop(const QString &file_name)
+{
+    QFile file(file_name);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "QxActionLogger: Unable to open" << file_name << file.errorString();
+        return;
+    }
+
+    char header[8] = {'Q', 'X', 'L', 'G'};
+    qToLittleEndian<quint32>(FormatVersion, header + 4);
+    file.write(header, sizeof(header));
+
+    QByteArray chunk(64 * 1024, Qt::Uninitialized);
+
+    for (;;) {
+        {
+            QMutexLocker locker(&mutex_);
+            if (!stopping_ && !wake_requested_ && ring_->size() == 0) {
+                wake_.wait(&mutex_, FlushInterval);
+            }
+        }
+
+        // Cleared before draining. A record written from now on may wake the writer again.
+        wake_requested_ = false;
+
+        // Read stopping_ before draining, so records written before stop() are not left behind.
+        const bool stopping = stopping_;
+        qsizetype length;
+
+        while ((length = ring_->read(chunk.data(), chunk.size())) > 0) {
+            file.write(chunk.constData(), length);
+        }
+
+        file.flush();
+
+        if (stopping) {
+            break;
+        }
+    }
+}
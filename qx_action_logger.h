@@ -0,0 +1,125 @@
+#ifndef QX_ACTION_LOGGER_H
+#define QX_ACTION_LOGGER_H
+
+#include <atomic>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQmlParserStatus>
+#include <QScopedPointer>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "qx_dispatcher.h"
+#include "private/qx_ring_buffer.h"
+
+class QxActionLogger : public QObject, public QQmlParserStatus
+{
+    Q_OBJECT
+    Q_PROPERTY(QObject *dispatcher READ dispatcher WRITE setDispatcher NOTIFY dispatcherChanged)
+    Q_PROPERTY(QString fileName READ fileName WRITE setFileName NOTIFY fileNameChanged)
+    Q_PROPERTY(QStringList types READ types WRITE setTypes NOTIFY typesChanged)
+    Q_PROPERTY(int bufferSize READ bufferSize WRITE setBufferSize NOTIFY bufferSizeChanged)
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(int droppedCount READ droppedCount NOTIFY droppedCountChanged)
+    Q_INTERFACES(QQmlParserStatus)
+    QML_ELEMENT
+public:
+    explicit QxActionLogger(QObject *parent = nullptr);
+    ~QxActionLogger();
+
+    QObject *dispatcher() const;
+    void setDispatcher(QObject *dispatcher);
+
+    QString fileName() const;
+    void setFileName(const QString &file_name);
+
+    QStringList types() const;
+    void setTypes(const QStringList &types);
+
+    int bufferSize() const;
+    void setBufferSize(int buffer_size);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    int droppedCount() const;
+
+    /// Ask the writer thread to write buffered records now.
+    Q_INVOKABLE void flush();
+
+    /// The version written in the file header.
+    static constexpr quint32 FormatVersion = 1;
+
+    /// Record kinds. A Type record introduces the name of an atom, and precedes the first Action record of the atom.
+    enum RecordKind : quint8 {
+        TypeRecord = 0,
+        ActionRecord = 1
+    };
+
+protected:
+    void classBegin();
+    void componentComplete();
+
+private:
+    // Stop logging, then start again if it is enabled and complete.
+    void restart();
+
+    void start();
+
+    void stop();
+
+    // Encode an action and append it to the ring buffer. Called by the dispatcher.
+    void record(const QString &type, const QVariant &message);
+
+    // Append the record in scratch_, filling its header. Returns false and counts a drop if it does not fit.
+    bool commit(RecordKind kind, quint64 sequence, qint64 timestamp, int atom);
+
+    // Body of the writer thread.
+    void writeLoop(const QString &file_name);
+
+    bool completed_;
+    QPointer<QxDispatcher> dispatcher_;
+    QString file_name_;
+    QStringList types_;
+    int buffer_size_;
+    bool enabled_;
+
+    int listener_id_;
+
+    // Written by the dispatcher thread, read by the writer thread.
+    QScopedPointer<QxRingBuffer> ring_;
+
+    QThread *writer_;
+    std::atomic<bool> stopping_;
+    QMutex mutex_;
+    QWaitCondition wake_;
+
+    // Set by the dispatcher thread when it wakes the writer, and cleared by the writer. It limits the
+    // dispatcher to one wakeOne() per round of the writer, without taking the mutex.
+    std::atomic<bool> wake_requested_;
+
+    QElapsedTimer clock_;
+    quint64 sequence_;
+    std::atomic<int> dropped_count_;
+
+    // Atoms whose Type record has been written.
+    QSet<int> known_atoms_;
+
+    // Reused to encode records, so logging an action does not allocate once it has grown.
+    // It is released after a large message grew it beyond 64 KiB.
+    QByteArray scratch_;
+
+signals:
+    void dispatcherChanged();
+    void fileNameChanged();
+    void typesChanged();
+    void bufferSizeChanged();
+    void enabledChanged();
+    void droppedCountChanged();
+};
+
+#endif // QX_ACTION_LOGGER_H
@@ -19,13 +19,25 @@ QxAppDispatcher::QxAppDispatcher(QObject *parent)
 
 QxAppDispatcher *QxAppDispatcher::instance(QQmlEngine *engine)
 {
-    QxAppDispatcher *dispatcher = qobject_cast<QxAppDispatcher*>(singletonObject(engine,"QuixFlux",1,0,"QxAppDispatcher"));
+    QxAppDispatcher *dispatcher = qobject_cast<QxAppDispatcher*>(QxEngineRegistry::object(engine, registryKey()));
+
+    if (!dispatcher) {
+        // QML has not instantiated the singleton yet.
+        dispatcher = qobject_cast<QxAppDispatcher*>(singletonObject(engine,"QuixFlux",1,0,"QxAppDispatcher"));
+    }
 
     return dispatcher;
 }
 
 QObject *QxAppDispatcher::singletonObject(QQmlEngine *engine, QString package, int versionMajor, int versionMinor, QString typeName)
 {
+    const QString key = QxEngineRegistry::key(package, versionMajor, typeName);
+
+    QObject *cached = QxEngineRegistry::object(engine, key);
+    if (cached) {
+        return cached;
+    }
+
     QString pattern  = "import QtQuick\nimport %1 %2.%3;QtObject { property var object : %4 }";
 
     QString qml = pattern.arg(package).arg(versionMajor).arg(versionMinor).arg(typeName);
@@ -48,7 +60,16 @@ QObject *QxAppDispatcher::singletonObject(QQmlEngine *engine, QString package, i
     if (!object) {
         qWarning() << QString("QuixFlux: Failed to gain singleton object: %1").arg(typeName);
         qWarning() << QString("Error: Unknown");
+        return 0;
     }
 
+    QxEngineRegistry::insert(engine, key, object);
+
     return object;
 }
+
+const QString &QxAppDispatcher::registryKey()
+{
+    static const QString key = QxEngineRegistry::key("QuixFlux", 1, "QxAppDispatcher");
+    return key;
+}
@@ -4,6 +4,7 @@
 #include <QQmlEngine>
 
 #include "qx_dispatcher.h"
+#include "private/qx_engine_registry.h"
 
 class QxAppDispatcher : public QxDispatcher
 {
@@ -18,6 +19,8 @@ public:
         QxAppDispatcher *result = new QxAppDispatcher();
         result->setEngine(qml_engine);
 
+        QxEngineRegistry::insert(qml_engine, registryKey(), result);
+
         return result;
     }
 
@@ -27,7 +30,11 @@ public:
     static QxAppDispatcher *instance(QQmlEngine *engine);
 
     /// Obtain a singleton object from package for specific QQmlEngine.
+    /// The object is cached per engine, so only the first call may need to compile QML.
     static QObject *singletonObject(QQmlEngine *engine,QString package, int versionMajor, int versionMinor, QString typeName);
+
+private:
+    static const QString &registryKey();
 };
 
 #endif // QX_APP_DISPATCHER_H
@@ -3,6 +3,18 @@
 
 #include "qx_app_listener.h"
 #include "qx_app_dispatcher.h"
+#include "qx_filter.h"
+#include "private/qx_atom_table.h"
+
+namespace {
+
+const QMetaMethod &dispatchedSignal()
+{
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QxAppListener::dispatched);
+    return signal;
+}
+
+} // namespace
 
 /*!
     \qmltype QxAppListener
@@ -80,8 +92,9 @@ QxAppListener::QxAppListener(QQuickItem *parent)
     , always_on_(false)
     , listener_(nullptr)
     , listener_id_(0)
+    , filter_index_(new QxFilterIndex(this))
 {
-    // Intentionally left empty.
+    connect(filter_index_, SIGNAL(changed()), this, SLOT(updateTypes()));
 }
 
 QxAppListener::~QxAppListener()
@@ -112,26 +125,22 @@ void QxAppListener::setTarget(QxDispatcher *target)
 
         listener_ = new QxListener(this);
 
+        // Declared before it is added, so it is indexed once.
+        updateTypes();
+
         setListenerId(target_->addListener(listener_));
 
         setListenerWaitFor();
 
-        connect(listener_, SIGNAL(dispatched(QString,QJSValue)),
-                this, SLOT(onMessageReceived(QString,QJSValue)));
+        connect(listener_, SIGNAL(dispatched(int,QString,QJSValue)),
+                this, SLOT(onMessageReceived(int,QString,QJSValue)));
     }
 }
 
 QxAppListener *QxAppListener::on(QString type, QJSValue callback)
 {
-    QList<QJSValue> list;
-
-    if (mapping_.contains(type)) {
-        list = mapping_[type];
-    }
-
-    list.append(callback);
-
-    mapping_[type] = list;
+    mapping_[QxAtomTable::intern(type)].append(callback);
+    updateTypes();
 
     return this;
 }
@@ -143,24 +152,23 @@ QxAppListener *QxAppListener::on(QString type, QJSValue callback)
 
 void QxAppListener::removeListener(QString type, QJSValue callback)
 {
-    if (!mapping_.contains(type)) {
+    auto iter = mapping_.find(QxAtomTable::lookup(type));
+    if (iter == mapping_.end()) {
         return;
     };
 
-    QList<QJSValue> list;
-    list = mapping_[type];
+    QList<QJSValue> &list = iter.value();
 
-    int index = -1;
     for (int i = 0 ; i < list.size() ;i++) {
         if (list.at(i).equals(callback)) {
-            index = i;
+            list.removeAt(i);
             break;
         }
     }
 
-    if (index >=0 ) {
-        list.removeAt(index);
-        mapping_[type] = list;
+    if (list.isEmpty()) {
+        mapping_.erase(iter);
+        updateTypes();
     }
 }
 
@@ -173,8 +181,10 @@ void QxAppListener::removeAllListener(QString type)
     if (type.isEmpty()) {
         mapping_.clear();
     } else {
-        mapping_.remove(type);
+        mapping_.remove(QxAtomTable::lookup(type));
     }
+
+    updateTypes();
 }
 
 /*! \qmlproperty string QxAppListener::filter
@@ -191,6 +201,7 @@ QString QxAppListener::filter() const
 void QxAppListener::setFilter(const QString &filter)
 {
     filter_ = filter;
+    updateFilterAtoms();
     emit filterChanged();
 }
 
@@ -206,6 +217,7 @@ QStringList QxAppListener::filters() const
 void QxAppListener::setFilters(const QStringList &filters)
 {
     filters_ = filters;
+    updateFilterAtoms();
     emit filtersChanged();
 }
 
@@ -257,6 +269,9 @@ void QxAppListener::setListenerId(int listener_id)
         }
     \endcode
 
+    The order of delivery is resolved when the dependencies change, not per message.
+    A value that would create a cyclic dependency is rejected with a warning.
+
  */
 
 QList<int> QxAppListener::waitFor() const
@@ -266,11 +281,20 @@ QList<int> QxAppListener::waitFor() const
 
 void QxAppListener::setWaitFor(const QList<int> &wait_for)
 {
+    if (listener_ && !listener_->setWaitFor(wait_for)) {
+        // Rejected due to a cyclic dependency. Keep the value the dispatcher plans with.
+        return;
+    }
+
     wait_for_ = wait_for;
-    setListenerWaitFor();
     emit waitForChanged();
 }
 
+QxFilterIndex *QxAppListener::filterIndex() const
+{
+    return filter_index_;
+}
+
 void QxAppListener::componentComplete()
 {
     QQuickItem::componentComplete();
@@ -286,42 +310,36 @@ void QxAppListener::componentComplete()
     }
 }
 
-void QxAppListener::onMessageReceived(QString type, QJSValue message)
+void QxAppListener::onMessageReceived(int atom, const QString &type, const QJSValue &message)
 {
     if (!isEnabled() && !always_on_)
         return;
 
-    bool dispatch = true;
-
-    QStringList rules = filters_;
-    if (!filter_.isEmpty()) {
-        rules.append(filter_);
-    }
+    if (filter_atoms_.isEmpty() || filter_atoms_.contains(atom)) {
+        emit dispatched(type,message);
 
-    if (rules.size() > 0) {
-        dispatch = false;
+        if (filter_index_->contains(atom)) {
+            // A shared copy, so it does not allocate. The index detaches if a filter changes it.
+            const QList<QxFilter *> filters = filter_index_->filters(atom);
 
-        for (int i = 0 ; i < rules.size() ; i++) {
-            if (type == rules.at(i)) {
-                dispatch = true;
-                break;
+            for (QxFilter *filter : filters) {
+                if (filter_index_->contains(atom, filter)) {
+                    filter->deliver(type, message);
+                }
             }
         }
     }
 
-    if (dispatch) {
-        emit dispatched(type,message);
-    }
-
     // Listener registered with on() should not be affected by filter.
 
-    if (!mapping_.contains(type))
+    auto iter = mapping_.constFind(atom);
+    if (iter == mapping_.constEnd())
         return;
 
-    QList<QJSValue> list = mapping_[type];
+    // The list shares its data with the mapping. It is only detached if a callback modifies the mapping.
+    const QList<QJSValue> list = iter.value();
 
-    QList<QJSValue> arguments;
-    arguments << message;
+    const QJSValueList arguments {message};
 
     for (const auto &value : list) {
         if (value.isCallable()) {
@@ -330,11 +348,74 @@ void QxAppListener::onMessageReceived(QString type, QJSValue message)
     }
 }
 
+void QxAppListener::updateFilterAtoms()
+{
+    filter_atoms_.clear();
+
+    for (const QString &filter : std::as_const(filters_)) {
+        filter_atoms_.insert(QxAtomTable::intern(filter));
+    }
+
+    if (!filter_.isEmpty()) {
+        filter_atoms_.insert(QxAtomTable::intern(filter_));
+    }
+
+    updateTypes();
+}
+
+void QxAppListener::updateTypes()
+{
+    if (!listener_) {
+        return;
+    }
+
+    QSet<int> types;
+
+    if (filter_atoms_.isEmpty()) {
+        if (isSignalConnected(dispatchedSignal())) {
+            // Any type may be handled by a receiver of the signal.
+            listener_->clearTypes();
+            return;
+        }
+
+        const QList<int> filtered = filter_index_->atoms();
+        types = QSet<int>(filtered.constBegin(), filtered.constEnd());
+    } else {
+        types = filter_atoms_;
+    }
+
+    for (auto iter = mapping_.constBegin() ; iter != mapping_.constEnd() ; iter++) {
+        types.insert(iter.key());
+    }
+
+    QList<int> atoms = types.values();
+    std::sort(atoms.begin(), atoms.end());
+    listener_->setTypes(atoms);
+}
+
+void QxAppListener::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == dispatchedSignal()) {
+        updateTypes();
+    }
+}
+
+void QxAppListener::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == dispatchedSignal()) {
+        updateTypes();
+    }
+}
+
 void QxAppListener::setListenerWaitFor()
 {
     if (!listener_) {
         return;
     }
 
-    listener_->setWaitFor(wait_for_);
+    if (!listener_->setWaitFor(wait_for_)) {
+        // Rejected due to a cyclic dependency. Report the value the dispatcher plans with.
+        wait_for_ = listener_->waitFor();
+        emit waitForChanged();
+    }
 }
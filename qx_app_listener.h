@@ -2,8 +2,10 @@
 #define QX_APP_LISTENER_H
 
 #include <QQuickItem>
+#include <QSet>
 
 #include "qx_dispatcher.h"
+#include "private/qx_filter_index.h"
 
 class QxAppListener : public QQuickItem
 {
@@ -54,19 +56,32 @@ public:
     QList<int> waitFor() const;
     void setWaitFor(const QList<int> &wait_for);
 
+    /// The QxFilter children of this listener. It is private API. Do not use it.
+    QxFilterIndex *filterIndex() const;
+
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
 private:
     virtual void componentComplete();
 
-    Q_INVOKABLE void onMessageReceived(QString type, QJSValue message);
+    Q_INVOKABLE void onMessageReceived(int atom, const QString &type, const QJSValue &message);
 
     void setListenerWaitFor();
 
+    void updateFilterAtoms();
+
     QPointer<QxDispatcher> target_;
 
-    QMap<QString, QList<QJSValue>> mapping_;
+    // Callbacks registered via on(), keyed by type atom
+    QHash<int, QList<QJSValue>> mapping_;
 
     QString filter_;
     QStringList filters_;
+
+    // Atoms of filter and filters
+    QSet<int> filter_atoms_;
     bool always_on_;
 
     int listener_id_;
@@ -74,6 +89,12 @@ private:
 
     QList<int> wait_for_;
 
+    QxFilterIndex *filter_index_;
+
+private slots:
+    // Report the types this listener may react to, so the dispatcher skips it for other types.
+    void updateTypes();
+
 signals:
     /// It is emitted whatever it has received a dispatched message from AppDispatcher.
     Q_SIGNAL void dispatched(QString type, QJSValue message);
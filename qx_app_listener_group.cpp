@@ -28,8 +28,12 @@ QList<int> QxAppListenerGroup::waitFor() const
 
 void QxAppListenerGroup::setWaitFor(const QList<int> &wait_for)
 {
+    if (listener_ && !listener_->setWaitFor(wait_for)) {
+        // Rejected due to a cyclic dependency. Keep the value the dispatcher plans with.
+        return;
+    }
+
     wait_for_ = wait_for;
-    setListenerWaitFor();
     emit waitForChanged();
 }
 
@@ -74,5 +78,13 @@ QList<int> QxAppListenerGroup::search(QQuickItem *item)
 
 void QxAppListenerGroup::setListenerWaitFor()
 {
-    listener_->setWaitFor(wait_for_);
+    if (!listener_) {
+        return;
+    }
+
+    if (!listener_->setWaitFor(wait_for_)) {
+        // Rejected due to a cyclic dependency. Report the value the dispatcher plans with.
+        wait_for_ = listener_->waitFor();
+        emit waitForChanged();
+    }
 }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <QQmlExpression>
 #include <QtDebug>
 #include <QtQml>
@@ -5,6 +6,7 @@
 #include "qx_app_script.h"
 #include "qx_app_listener.h"
 #include "private/qx_app_script_runnable.h"
+#include "private/qx_atom_table.h"
 
 /*! \qmltype QxAppScript
     \inqmlmodule QuixFlux
@@ -92,6 +94,7 @@ QxAppScript::run() / QxAppScript::exit() clear all the registered callback compl
 
 QxAppScript::QxAppScript(QQuickItem *parent)
     : QQuickItem{parent}
+    , run_when_atom_(0)
     , running_(false)
     , processing_(false)
     , listener_id_(0)
@@ -101,6 +104,12 @@ QxAppScript::QxAppScript(QQuickItem *parent)
     // Intentionally left empty.
 }
 
+QxAppScript::~QxAppScript()
+{
+    // Disconnect the callbacks from their signals, so they do not call a deleted script.
+    clear();
+}
+
 /*! \qmlproperty script AppScript::script
     This property holds the script to run.
  */
@@ -139,6 +148,8 @@ QString QxAppScript::runWhen() const
 void QxAppScript::setRunWhen(const QString &run_when)
 {
     run_when_ = run_when;
+    run_when_atom_ = run_when_.isEmpty() ? 0 : QxAtomTable::intern(run_when_);
+    updateTypes();
     emit runWhenChanged();
 }
 
@@ -171,8 +182,12 @@ QList<int> QxAppScript::waitFor() const
 
 void QxAppScript::setWaitFor(const QList<int> &wait_for)
 {
+    if (listener_ && !listener_->setWaitFor(wait_for)) {
+        // Rejected due to a cyclic dependency. Keep the value the dispatcher plans with.
+        return;
+    }
+
     wait_for_ = wait_for;
-    setListenerWaitFor();
     emit waitForChanged();
 }
 
@@ -195,6 +210,7 @@ void QxAppScript::exit(int returnCode)
 {
     clear();
     setRunning(false);
+    updateTypes();
     emit finished(returnCode);
 }
 
@@ -240,6 +256,7 @@ void QxAppScript::run(QJSValue message)
     }
 
     processing_ = false;
+    updateTypes();
 }
 
 /*! \qmlmethod chian AppScript::once(var type, func callback)
@@ -248,6 +265,9 @@ void QxAppScript::run(QJSValue message)
     It will be triggered once only.
     User should call this function within the script code block.
 
+    A signal is passed to the callback directly. It is not dispatched, so other listeners do not receive it.
+    If it is emitted while an action is being dispatched, the callback runs once the action is delivered.
+
     The callback will be removed on script termination.
 
     Moreover, this function is chainable:
@@ -274,15 +294,26 @@ void QxAppScript::run(QJSValue message)
 
     The callback in then() will not be registrated immediately.
     It is deferred until the previouew callback triggered.
+
+    once() and then() return a lightweight chain handle. A callback is released as soon as it is done,
+    and all of them are released immediately by exit().
  */
-QxAppScriptRunnable *QxAppScript::once(QJSValue condition, QJSValue script)
+QJSValue QxAppScript::once(QJSValue condition, QJSValue script)
 {
-    QxAppScriptRunnable *runnable = new QxAppScriptRunnable(this);
-    runnable->setEngine(qmlEngine(this));
-    runnable->setCondition(condition);
-    runnable->setScript(script);
-    runnables_.append(runnable);
-    return runnable;
+    const int id = createRunnable(condition, script);
+
+    if (id < 0) {
+        return handle(-1);
+    }
+
+    addRunnable(id);
+
+    // The types are declared once the script or callback calling it has returned.
+    if (!processing_) {
+        updateTypes();
+    }
+
+    return handle(id);
 }
 
 /*! \qmlmethod AppScript::on(var type, func callback)
@@ -294,8 +325,122 @@ QxAppScriptRunnable *QxAppScript::once(QJSValue condition, QJSValue script)
 
 void QxAppScript::on(QJSValue condition, QJSValue script)
 {
-    QxAppScriptRunnable *runnable = once(condition,script);
-    runnable->setIsOnceOnly(false);
+    const int id = createRunnable(condition, script);
+
+    if (id < 0) {
+        return;
+    }
+
+    pool_.at(id)->is_once_only = false;
+    addRunnable(id);
+
+    if (!processing_) {
+        updateTypes();
+    }
+}
+
+QJSValue QxAppScript::_then(int id, QJSValue condition, QJSValue script)
+{
+    if (!pool_.at(id)) {
+        // The chain is terminated, e.g. by exit(). Further steps are ignored.
+        return handle(-1);
+    }
+
+    const int next = createRunnable(condition, script);
+
+    if (next < 0) {
+        return handle(-1);
+    }
+
+    QxAppScriptRunnable *runnable = pool_.at(id);
+
+    // Calling then() again on the same step replaces the rest of the chain.
+    const int previous = runnable->next;
+    runnable->next = next;
+    pool_.free(previous);
+
+    return handle(next);
+}
+
+void QxAppScript::_trigger(int id, QJSValue arguments)
+{
+    trigger(id, arguments);
+}
+
+void QxAppScript::trigger(int id, const QJSValue &arguments)
+{
+    if (dispatcher_.isNull()) {
+        onTriggered(id, arguments);
+        return;
+    }
+
+    dispatcher_->defer(this, [this, id, arguments]() {
+        onTriggered(id, arguments);
+    });
+}
+
+int QxAppScript::createRunnable(const QJSValue &condition, const QJSValue &script)
+{
+    const int id = pool_.create();
+    QxAppScriptRunnable *runnable = pool_.at(id);
+
+    if (!runnable) {
+        return -1;
+    }
+
+    runnable->script = script;
+    runnable->condition = condition;
+
+    if (condition.isString()) {
+        runnable->atom = QxAtomTable::intern(condition.toString());
+    } else if (condition.isObject() && condition.hasProperty("connect")) {
+        // The signal is passed to the runnable directly. It is not dispatched, so other listeners do not see it.
+        QJSValue callback = functions().property("trigger").call(QJSValueList() << id);
+
+        runnable->callback = callback;
+        runnable->is_signal_condition = true;
+
+        QJSValue connect = condition.property("connect");
+        connect.callWithInstance(condition, QJSValueList() << callback);
+    } else {
+        qWarning() << "AppScript: Invalid condition type";
+    }
+
+    return id;
+}
+
+QJSValue QxAppScript::handle(int id)
+{
+    return functions().property("handle").call(QJSValueList() << id);
+}
+
+QJSValue QxAppScript::functions()
+{
+    if (!functions_.isUndefined()) {
+        return functions_;
+    }
+
+    QQmlEngine *engine = qmlEngine(this);
+
+    if (!engine) {
+        return QJSValue();
+    }
+
+    QJSValue generator = engine->evaluate("(function(script) {"
+                                          "    return {"
+                                          "        handle: function(id) {"
+                                          "            return { then: function(condition, callback) { return script._then(id, condition, callback); } };"
+                                          "        },"
+                                          "        trigger: function(id) {"
+                                          "            return function() { script._trigger(id, arguments); };"
+                                          "        }"
+                                          "    };"
+                                          "})");
+
+    QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
+    functions_ = generator.call(QJSValueList() << engine->newQObject(this));
+
+    return functions_;
 }
 
 void QxAppScript::componentComplete()
@@ -310,12 +455,15 @@ void QxAppScript::componentComplete()
 
     listener_ = new QxListener(this);
 
+    // An idle script is only interested in runWhen.
+    updateTypes();
+
     setListenerId(dispatcher_->addListener(listener_));
 
     setListenerWaitFor();
 
-    connect(listener_, SIGNAL(dispatched(QString,QJSValue)),
-            this, SLOT(onDispatched(QString,QJSValue)));
+    connect(listener_, SIGNAL(dispatched(int,QString,QJSValue)),
+            this, SLOT(onDispatched(int,QString,QJSValue)));
 }
 
 void QxAppScript::abort()
@@ -325,10 +473,9 @@ void QxAppScript::abort()
 
 void QxAppScript::clear()
 {
-    for (int i = 0 ; i < runnables_.size(); i++) {
-        runnables_[i]->deleteLater();
-    }
+    pool_.clear();
     runnables_.clear();
+    runnable_index_.clear();
 }
 
 void QxAppScript::setRunning(bool running)
@@ -346,13 +493,121 @@ void QxAppScript::setListenerWaitFor()
         return;
     }
 
-    listener_->setWaitFor(wait_for_);
+    if (!listener_->setWaitFor(wait_for_)) {
+        // Rejected due to a cyclic dependency. Report the value the dispatcher plans with.
+        wait_for_ = listener_->waitFor();
+        emit waitForChanged();
+    }
 }
 
-void QxAppScript::onDispatched(QString type, QJSValue message)
+void QxAppScript::addRunnable(int id)
 {
-    if (!run_when_.isEmpty() &&
-        type == run_when_ &&
+    runnables_.append(id);
+
+    // A signal condition is triggered directly. It does not wait for a type.
+    const int atom = pool_.at(id)->atom;
+
+    if (atom > 0) {
+        runnable_index_[atom].append(id);
+    }
+}
+
+void QxAppScript::removeRunnable(int id)
+{
+    QxAppScriptRunnable *runnable = pool_.at(id);
+
+    if (!runnable) {
+        return;
+    }
+
+    runnables_.removeOne(id);
+
+    auto iter = runnable_index_.find(runnable->atom);
+
+    if (iter != runnable_index_.end()) {
+        iter->removeOne(id);
+
+        if (iter->isEmpty()) {
+            runnable_index_.erase(iter);
+        }
+    }
+
+    const int next = runnable->next;
+
+    // Detach the rest of the chain, so it is not freed with the runnable.
+    runnable->next = -1;
+    pool_.free(id);
+
+    if (pool_.at(next)) {
+        addRunnable(next);
+    }
+}
+
+void QxAppScript::onTriggered(int id, const QJSValue &arguments)
+{
+    // A runnable chained by then() is connected to its signal before it is registered.
+    if (!running_ || !runnables_.contains(id)) {
+        return;
+    }
+
+    const bool processing = processing_;
+    processing_ = true;
+
+    pool_.at(id)->run(arguments);
+
+    if (!running_) {
+        // Terminate if exit() is called in runnable
+        processing_ = processing;
+        return;
+    }
+
+    QxAppScriptRunnable *runnable = pool_.at(id);
+
+    if (runnable && runnable->is_once_only) {
+        removeRunnable(id);
+    }
+
+    processing_ = processing;
+
+    if (processing_) {
+        // It is triggered by run() or a callback. The rest is done when it returns.
+        return;
+    }
+
+    // All the tasks are finished
+    if (runnables_.size() == 0 && auto_exit_) {
+        exit(0);
+    } else {
+        updateTypes();
+    }
+}
+
+void QxAppScript::updateTypes()
+{
+    if (!listener_) {
+        return;
+    }
+
+    QList<int> atoms;
+
+    if (running_) {
+        atoms = runnable_index_.keys();
+    }
+
+    if (run_when_atom_ > 0 && !atoms.contains(run_when_atom_)) {
+        atoms << run_when_atom_;
+    }
+
+    std::sort(atoms.begin(), atoms.end());
+    listener_->setTypes(atoms);
+}
+
+void QxAppScript::onDispatched(int atom, const QString &type, const QJSValue &message)
+{
+    Q_UNUSED(type);
+
+    if (run_when_atom_ > 0 &&
+        atom == run_when_atom_ &&
         !processing_) {
 
         if (running_) {
@@ -366,23 +621,35 @@ void QxAppScript::onDispatched(QString type, QJSValue message)
         return;
     }
 
+    if (!runnable_index_.contains(atom)) {
+        return;
+    }
+
     processing_ = true;
 
-    // Mark for removeal
     QList<int> marked;
 
-    for (int i = 0 ; i < runnables_.size() ; i++) {
-        if (runnables_[i]->type() == type) {
-            runnables_[i]->run(message);
+    // Runnables registered for the same type by a callback are run in this round too.
+    for (int i = 0 ; i < runnable_index_.value(atom).size() ; i++) {
+        const int id = runnable_index_.value(atom).at(i);
+        QxAppScriptRunnable *runnable = pool_.at(id);
 
-            if (!running_) {
-                // If exit() is called in runnable. It shoud not process any more.
-                break;
-            }
+        if (!runnable) {
+            continue;
+        }
 
-            if (runnables_[i]->isOnceOnly()) {
-                marked << i;
-            }
+        runnable->run(message);
+
+        if (!running_) {
+            // If exit() is called in runnable. It shoud not process any more.
+            break;
+        }
+
+        // The pointer is not held across run(). A callback may grow the pool, or restart the script and clear it.
+        runnable = pool_.at(id);
+
+        if (runnable && runnable->is_once_only) {
+            marked << id;
         }
     }
 
@@ -392,17 +659,8 @@ void QxAppScript::onDispatched(QString type, QJSValue message)
         return;
     }
 
-    for (int i = marked.size() - 1 ; i >= 0 ; i--) {
-        int idx = marked[i];
-        QxAppScriptRunnable *runnable = runnables_.takeAt(idx);
-
-        QxAppScriptRunnable *next = runnable->next();
-        if (next) {
-            next->setParent(this);
-            runnables_.append(next);
-        }
-        runnable->release();
-        runnable->deleteLater();
+    for (int id : std::as_const(marked)) {
+        removeRunnable(id);
     }
 
     processing_ = false;
@@ -410,5 +668,7 @@ void QxAppScript::onDispatched(QString type, QJSValue message)
     // All the tasks are finished
     if (runnables_.size() == 0 && auto_exit_) {
         exit(0);
+    } else {
+        updateTypes();
     }
 }
@@ -5,9 +5,9 @@
 #include <QQuickItem>
 
 #include "qx_app_dispatcher.h"
+#include "private/qx_app_script_runnable.h"
 
 class QxListener;
-class QxAppScriptRunnable;
 
 class QxAppScript : public QQuickItem
 {
@@ -22,6 +22,7 @@ class QxAppScript : public QQuickItem
     QML_ELEMENT
 public:
     explicit QxAppScript(QQuickItem *parent = nullptr);
+    ~QxAppScript();
 
     QQmlScriptString script() const;
     void setScript(const QQmlScriptString &script);
@@ -47,9 +48,15 @@ public slots:
     void exit(int returnCode = 0);
     void run(QJSValue message = QJSValue());
 
-    QxAppScriptRunnable *once(QJSValue condition, QJSValue script);
+    QJSValue once(QJSValue condition, QJSValue script);
     void on(QJSValue condition, QJSValue script);
 
+    /// Chain a runnable to the runnable of id. It is called by the chain handle. It is private API. Do not use it.
+    QJSValue _then(int id, QJSValue condition, QJSValue script);
+
+    /// Called by the signal of the condition of the runnable of id. It is private API. Do not use it.
+    void _trigger(int id, QJSValue arguments);
+
 private:
     virtual void componentComplete();
     void abort();
@@ -58,10 +65,45 @@ private:
 
     void setListenerWaitFor();
 
+    // Allocate a runnable in the pool. A signal condition is connected immediately. Returns -1 if the pool is full.
+    int createRunnable(const QJSValue &condition, const QJSValue &script);
+
+    // Register a runnable waiting for its condition.
+    void addRunnable(int id);
+
+    // Remove and free a triggered runnable. The next runnable of its chain is registered in its place.
+    void removeRunnable(int id);
+
+    // Run a runnable whose signal condition is emitted. It is deferred until the action being dispatched
+    // is delivered, as if the signal were an action.
+    void trigger(int id, const QJSValue &arguments);
+
+    void onTriggered(int id, const QJSValue &arguments);
+
+    // Obtain the chain handle returned by once() and then() for the runnable of id.
+    QJSValue handle(int id);
+
+    // The JavaScript helpers creating chain handles and signal callbacks. Built on first use.
+    QJSValue functions();
+
+    // Declare the types of the listener: runWhen, and the conditions of the runnables while it is running.
+    void updateTypes();
+
     QQmlScriptString script_;
-    QList<QxAppScriptRunnable *> runnables_;
+
+    // Runnables and their chained runnables. They are freed as soon as they are done.
+    QxAppScriptRunnablePool pool_;
+
+    // Ids of the runnables waiting for their condition, in registration order.
+    QList<int> runnables_;
+
+    // Ids of runnables waiting for a type, keyed by its atom. Kept in registration order.
+    QHash<int, QList<int>> runnable_index_;
+
+    QJSValue functions_;
     QPointer<QxAppDispatcher> dispatcher_;
     QString run_when_;
+    int run_when_atom_;
 
     bool running_;
     bool processing_;
@@ -77,7 +119,7 @@ private:
     QList<int> wait_for_;
 
 private slots:
-    void onDispatched(QString type, QJSValue message);
+    void onDispatched(int atom, const QString &type, const QJSValue &message);
 
 signals:
     void started();
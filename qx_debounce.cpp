@@ -0,0 +1,166 @@
+#include <QtDebug>
+
+#include "qx_debounce.h"
+#include "private/qx_timer_service.h"
+
+/*!
+    \qmltype QxDebounce
+    \inqmlmodule QuixFlux
+    \brief A native middleware passing an action once its type has been quiet for an interval
+
+    \code
+        import QuixFlux
+    \endcode
+
+    QxDebounce is placed in a QxMiddlewareList. For each type in types, and each value at keyPath,
+    it holds actions until none has arrived for interval msecs, then passes the latest one.
+    If leading is true, the first action of a burst is passed immediately instead.
+
+    Suppressed actions are dropped in C++, so they never reach JavaScript.
+    The timers of all instances are served by a single timer.
+
+    \code
+        QxMiddlewareList {
+            applyTarget: QxAppDispatcher
+
+            QxDebounce {
+                types: [ActionTypes.search]
+                interval: 300
+            }
+        }
+    \endcode
+ */
+
+/*! \qmlproperty array QxDebounce::types
+    The types it applies to. If it is empty, every action is debounced.
+ */
+
+/*! \qmlproperty string QxDebounce::keyPath
+    A dot separated path into the message. Actions with different values at the path are debounced independently.
+ */
+
+/*! \qmlproperty int QxDebounce::interval
+    The quiet period in msecs. The default value is 100.
+ */
+
+QxDebounce::QxDebounce(QQuickItem *parent)
+    : QxKeyedMiddleware{parent}
+    , leading_(false)
+    , trailing_(true)
+    , edges_warned_(false)
+{
+    // Intentionally left empty.
+}
+
+QxDebounce::~QxDebounce()
+{
+    for (const Burst &burst : std::as_const(bursts_)) {
+        QxTimerService::instance()->stop(burst.timer);
+    }
+}
+
+/*! \qmlproperty bool QxDebounce::leading
+    If it is true, the first action of a burst is passed immediately. The default value is false.
+ */
+
+bool QxDebounce::leading() const
+{
+    return leading_;
+}
+
+void QxDebounce::setLeading(bool leading)
+{
+    if (leading_ == leading) {
+        return;
+    }
+
+    leading_ = leading;
+    emit leadingChanged();
+}
+
+/*! \qmlproperty bool QxDebounce::trailing
+    If it is true, the latest action of a burst is passed when it has ended.
+    The first action of a burst is not passed twice. The default value is true.
+    If both leading and trailing are false, actions are passed on untouched with a warning.
+ */
+
+bool QxDebounce::trailing() const
+{
+    return trailing_;
+}
+
+void QxDebounce::setTrailing(bool trailing)
+{
+    if (trailing_ == trailing) {
+        return;
+    }
+
+    trailing_ = trailing;
+    emit trailingChanged();
+}
+
+void QxDebounce::dispatch(const QxAction &action)
+{
+    if (!accepts(action)) {
+        next(action);
+        return;
+    }
+
+    if (!leading_ && !trailing_) {
+        // Nothing would ever be passed. The action is passed on untouched instead.
+        if (!edges_warned_) {
+            qWarning() << "QxDebounce: Neither leading nor trailing is enabled. Actions are not debounced.";
+            edges_warned_ = true;
+        }
+        next(action);
+        return;
+    }
+
+    Key key;
+
+    if (!keyOf(action, &key)) {
+        next(action);
+        return;
+    }
+
+    auto iter = bursts_.find(key);
+
+    if (iter != bursts_.end()) {
+        QxTimerService::instance()->stop(iter->timer);
+        iter->timer = startQuietTimer(key);
+
+        if (trailing_) {
+            iter->trailing = action;
+        }
+        return;
+    }
+
+    Burst burst;
+    burst.timer = startQuietTimer(key);
+
+    if (!leading_ && trailing_) {
+        burst.trailing = action;
+    }
+
+    bursts_.insert(key, burst);
+
+    if (leading_) {
+        next(action);
+    }
+}
+
+int QxDebounce::startQuietTimer(const Key &key)
+{
+    return QxTimerService::instance()->start(interval(), this, [this, key]() {
+        onQuiet(key);
+    });
+}
+
+void QxDebounce::onQuiet(const Key &key)
+{
+    const Burst burst = bursts_.take(key);
+
+    if (!burst.trailing.isNull()) {
+        next(burst.trailing);
+    }
+}
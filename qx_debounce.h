@@ -0,0 +1,50 @@
+#ifndef QX_DEBOUNCE_H
+#define QX_DEBOUNCE_H
+
+#include <QHash>
+
+#include "qx_keyed_middleware.h"
+
+class QxDebounce : public QxKeyedMiddleware
+{
+    Q_OBJECT
+    Q_PROPERTY(bool leading READ leading WRITE setLeading NOTIFY leadingChanged)
+    Q_PROPERTY(bool trailing READ trailing WRITE setTrailing NOTIFY trailingChanged)
+    QML_ELEMENT
+public:
+    explicit QxDebounce(QQuickItem *parent = nullptr);
+    ~QxDebounce();
+
+    bool leading() const;
+    void setLeading(bool leading);
+
+    bool trailing() const;
+    void setTrailing(bool trailing);
+
+    void dispatch(const QxAction &action) override;
+
+signals:
+    void leadingChanged();
+    void trailingChanged();
+
+private:
+    // A burst of actions less than interval msecs apart. The latest one is kept for the trailing edge.
+    struct Burst
+    {
+        int timer = 0;
+        QxAction trailing;
+    };
+
+    int startQuietTimer(const Key &key);
+
+    void onQuiet(const Key &key);
+
+    bool leading_;
+    bool trailing_;
+
+    // True once a dispatch has warned that neither edge is enabled.
+    bool edges_warned_;
+    QHash<Key, Burst> bursts_;
+};
+
+#endif // QX_DEBOUNCE_H
@@ -0,0 +1,82 @@
+#include "qx_dedupe.h"
+#include "private/qx_timer_service.h"
+
+/*!
+    \qmltype QxDedupe
+    \inqmlmodule QuixFlux
+    \brief A native middleware dropping repeated actions
+
+    \code
+        import QuixFlux
+    \endcode
+
+    QxDedupe is placed in a QxMiddlewareList. It passes an action of a type in types, then drops actions
+    of the same type and key for interval msecs. The key is the value at keyPath, or the whole message if keyPath is not set.
+    With an interval of 0, only duplicates dispatched before control returns to the event loop are dropped.
+
+    Dropped actions never reach JavaScript. The timers of all instances are served by a single timer.
+
+    \code
+        QxMiddlewareList {
+            applyTarget: QxAppDispatcher
+
+            QxDedupe {
+                types: [ActionTypes.openItem]
+                keyPath: "id"
+                interval: 500
+            }
+        }
+    \endcode
+ */
+
+/*! \qmlproperty array QxDedupe::types
+    The types it applies to. If it is empty, every action is deduplicated.
+ */
+
+/*! \qmlproperty string QxDedupe::keyPath
+    A dot separated path into the message. Actions are duplicates if they have the same type and value at the path.
+ */
+
+/*! \qmlproperty int QxDedupe::interval
+    How long a passed action is remembered in msecs. The default value is 100.
+ */
+
+QxDedupe::QxDedupe(QQuickItem *parent)
+    : QxKeyedMiddleware{parent}
+{
+    // Intentionally left empty.
+}
+
+QxDedupe::~QxDedupe()
+{
+    for (int timer : std::as_const(seen_)) {
+        QxTimerService::instance()->stop(timer);
+    }
+}
+
+void QxDedupe::dispatch(const QxAction &action)
+{
+    if (!accepts(action)) {
+        next(action);
+        return;
+    }
+
+    Key key;
+
+    // Without a keyPath, the whole message is the key.
+    if (!keyOf(action, &key) ||
+        (keyPath().isEmpty() && !encodeKey(valueAt(action, QStringList()), &key.second))) {
+        next(action);
+        return;
+    }
+
+    if (seen_.contains(key)) {
+        return;
+    }
+
+    seen_.insert(key, QxTimerService::instance()->start(interval(), this, [this, key]() {
+        seen_.remove(key);
+    }));
+
+    next(action);
+}
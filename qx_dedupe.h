@@ -0,0 +1,23 @@
+#ifndef QX_DEDUPE_H
+#define QX_DEDUPE_H
+
+#include <QHash>
+
+#include "qx_keyed_middleware.h"
+
+class QxDedupe : public QxKeyedMiddleware
+{
+    Q_OBJECT
+    QML_ELEMENT
+public:
+    explicit QxDedupe(QQuickItem *parent = nullptr);
+    ~QxDedupe();
+
+    void dispatch(const QxAction &action) override;
+
+private:
+    // Keys passed within the last interval, and the timers forgetting them.
+    QHash<Key, int> seen_;
+};
+
+#endif // QX_DEDUPE_H
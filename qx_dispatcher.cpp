@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <iterator>
 #include <QtCore>
 #include <QtQml>
 #include <QVariant>
@@ -6,6 +8,21 @@
 
 #include "qx_dispatcher.h"
 #include "private/quix_functions.h"
+#include "private/qx_atom_table.h"
+
+namespace {
+
+// Maximum number of posted actions taken per drainInbox() call.
+// The rest is delivered in the next call, so the event loop is not blocked for long.
+constexpr int kInboxBatchSize = 1024;
+
+const QMetaMethod &dispatchedSignal()
+{
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&QxDispatcher::dispatched);
+    return signal;
+}
+
+} // namespace
 
 /*!
    \qmltype QxDispatcher
@@ -72,12 +89,22 @@
             }
         }
         \endcode
+
+    \b{The order of receivers}
+
+    A bound QxStore is not a receiver of this signal. Stores receive an action after the listeners and
+    the native listeners, and before this signal is emitted. So a Connections handler always sees the stores
+    updated by the action, whichever was created first. A handler which must run before the stores
+    should be a QxAppListener instead.
  */
 
 QxDispatcher::QxDispatcher(QObject *parent)
     : QObject(parent)
     , is_dispatching_(false)
-    , next_listener_id_(1)
+    , plans_version_(0)
+    , next_native_listener_id_(1)
+    , dispatching_slot_(-1)
+    , inbox_scheduled_(false)
 {
     // Intentionally left empty.
 }
@@ -113,29 +140,245 @@ void QxDispatcher::dispatch(QString type, QJSValue message)
 {
     QX_PRECHECK_DISPATCH(engine_.data(), type, message);
 
-    auto process = [=](QString type, QJSValue message) {
-        if (hook_.isNull()) {
-            send(type, message);
-        } else {
-            hook_->dispatch(type, message);
-        }
-    };
+    int atom = QxAtomTable::intern(type);
 
     if (is_dispatching_) {
-        queue_.enqueue(QPair<QString,QJSValue> (type,message) );
+        queue_.enqueue(QxAction(atom, message));
         return;
     }
 
     is_dispatching_ = true;
-    process(type,message);
+    process(QxAction(atom, message));
+    drain();
+    is_dispatching_ = false;
+}
 
-    while (queue_.size() > 0) {
-        QPair<QString,QJSValue> pair = queue_.dequeue();
-        process(pair.first,pair.second);
+/*!
+  \qmlmethod QxDispatcher::dispatchWithOptions(string type, object message, object options)
+
+    Dispatch an action like dispatch() with delivery options. They only take effect if the action has to wait in the queue.
+
+    \list
+    \li priority - The lane of the queue: QxDispatcher.HighPriority, QxDispatcher.NormalPriority or QxDispatcher.LowPriority.
+         Queued actions of a higher priority are delivered first. The default is the priority set by setTypePriority().
+    \li timeout - The time in milliseconds the action stays useful. It is dropped if it is still queued after that.
+    \endlist
+
+    The order of actions within the same priority is always preserved.
+
+    \code
+    AppDispatcher.dispatchWithOptions(ActionTypes.showPreview, { id: id }, {
+        priority: QxDispatcher.HighPriority,
+        timeout: 500
+    });
+    \endcode
+ */
+void QxDispatcher::dispatchWithOptions(QString type, QJSValue message, QJSValue options)
+{
+    QX_PRECHECK_DISPATCH(engine_.data(), type, message);
+
+    if (!is_dispatching_) {
+        dispatch(type, message);
+        return;
     }
+
+    int atom = QxAtomTable::intern(type);
+    int lane = queue_.lane(atom);
+    QDeadlineTimer deadline(QDeadlineTimer::Forever);
+
+    if (options.hasProperty("priority")) {
+        lane = options.property("priority").toInt();
+    }
+
+    if (options.hasProperty("timeout")) {
+        deadline.setRemainingTime(options.property("timeout").toInt());
+    }
+
+    queue_.enqueue(QxAction(atom, message), lane, deadline);
+}
+
+/*!
+  \qmlmethod QxDispatcher::dispatchBatch(array actions)
+
+    Dispatch a list of actions. Each item is an object with "type" and "message" properties.
+
+    The actions are delivered one by one, in the given order. Neither the priority set by setTypePriority()
+    nor the coalescing policy applies to them, so every listener receives each of them in that order.
+    Actions dispatched by listeners in the meantime, whatever their priority, are delivered after the batch.
+    If the dispatcher is busy, the batch is queued after the actions waiting in the normal priority lane.
+
+    It saves the overhead of calling dispatch() per action. Consecutive actions which no middleware handles and which
+    reach the same listeners are delivered in a single pass, looking up their listeners once.
+    The middlewares and listeners still run once per action.
+
+    \code
+    AppDispatcher.dispatchBatch([
+        { type: ActionTypes.updateItem, message: { id: 1, value: "a" } },
+        { type: ActionTypes.updateItem, message: { id: 2, value: "b" } }
+    ]);
+    \endcode
+ */
+void QxDispatcher::dispatchBatch(const QJSValue &actions)
+{
+    if (!actions.isArray()) {
+        qWarning() << "QxDispatcher::dispatchBatch() - Invalid input: an array is expected.";
+        return;
+    }
+
+    const int count = actions.property("length").toInt();
+    QList<QxAction> batch;
+    batch.reserve(count);
+
+    for (int i = 0 ; i < count ; i++) {
+        QJSValue action = actions.property(i);
+        QString type = action.property("type").toString();
+        QJSValue message = action.property("message");
+
+        QX_PRECHECK_DISPATCH(engine_.data(), type, message);
+        batch << QxAction(QxAtomTable::intern(type), message);
+    }
+
+    dispatchActions(batch);
+}
+
+/*! \fn QxDispatcher::dispatchBatch(const QList<QPair<QString, QVariant>> &actions)
+
+    Dispatch a list of \a actions in the given order. Each action is a pair of type and message.
+    Like the QML version, it bypasses priorities and coalescing.
+ */
+void QxDispatcher::dispatchBatch(const QList<QPair<QString, QVariant>> &actions)
+{
+    QList<QxAction> batch;
+    batch.reserve(actions.size());
+
+    for (const auto &action : actions) {
+        batch << QxAction(QxAtomTable::intern(action.first), action.second);
+    }
+
+    dispatchActions(batch);
+}
+
+void QxDispatcher::dispatchActions(const QList<QxAction> &actions)
+{
+    if (is_dispatching_) {
+        queue_.reserve(actions.size());
+
+        for (const QxAction &action : actions) {
+            queue_.append(action);
+        }
+        return;
+    }
+
+    is_dispatching_ = true;
+
+    const QxAction *iter = actions.constData();
+    const QxAction *end = iter + actions.size();
+
+    while (iter != end) {
+        if (!hook_.isNull() && hook_->handles(iter->atom())) {
+            process(*iter);
+            runDeferred();
+            iter++;
+            continue;
+        }
+
+        // A run of actions passing the hook untouched and reaching the same listeners is delivered in one pass.
+        const QList<int> indices = plan(iter->atom());
+        const QxAction *run_end = iter + 1;
+
+        while (run_end != end &&
+               (hook_.isNull() || !hook_->handles(run_end->atom())) &&
+               (run_end->atom() == iter->atom() || plan(run_end->atom()) == indices)) {
+            run_end++;
+        }
+
+        deliver(iter, run_end, indices);
+        runDeferred();
+        iter = run_end;
+    }
+
+    drain();
     is_dispatching_ = false;
 }
 
+/*!
+  \qmlmethod QxDispatcher::setCoalescePolicy(string type, enumeration policy, func merge)
+
+    Set how queued actions of a type are coalesced. It is useful for high frequency actions like
+    scroll position, slider drag or sensor readings, whose intermediate values are not needed.
+
+    \list
+    \li QxDispatcher.KeepAll - Every action is delivered. It is the default.
+    \li QxDispatcher.LatestWins - A new action replaces the queued action of the same type.
+    \li QxDispatcher.Merge - A queued action of the same type is replaced by merge(queuedMessage, newMessage).
+    \endlist
+
+    A coalesced action keeps the position of the queued one. Only actions waiting in the queue are affected,
+    an action dispatched while the dispatcher is idle is delivered immediately.
+
+    \code
+    Component.onCompleted: {
+        AppDispatcher.setCoalescePolicy(ActionTypes.scrollTo, QxDispatcher.LatestWins);
+        AppDispatcher.setCoalescePolicy(ActionTypes.addDelta, QxDispatcher.Merge, function(queued, next) {
+            return { delta: queued.delta + next.delta };
+        });
+    }
+    \endcode
+ */
+void QxDispatcher::setCoalescePolicy(const QString &type, QxDispatcher::CoalescePolicy policy, const QJSValue &merge)
+{
+    queue_.setPolicy(QxAtomTable::intern(type), static_cast<QxActionQueue::Policy>(policy), merge);
+}
+
+/*!
+  \qmlmethod QxDispatcher::setTypePriority(string type, enumeration priority)
+
+    Set the default priority of queued actions with the type.
+    It could keep user input actions from being stuck behind bulk actions.
+    The default is QxDispatcher.NormalPriority.
+
+    \code
+    AppDispatcher.setTypePriority(ActionTypes.importRecord, QxDispatcher.LowPriority);
+    \endcode
+ */
+void QxDispatcher::setTypePriority(const QString &type, QxDispatcher::Priority priority)
+{
+    queue_.setLane(QxAtomTable::intern(type), priority);
+}
+
+/*!
+  \qmlmethod int QxDispatcher::queueDepth(enumeration priority)
+
+    Obtain the number of queued actions with the priority.
+ */
+int QxDispatcher::queueDepth(QxDispatcher::Priority priority) const
+{
+    return queue_.size(priority);
+}
+
+/*!
+  \qmlmethod int QxDispatcher::expiredCount()
+
+    Obtain the number of actions dropped because their timeout elapsed in the queue.
+ */
+int QxDispatcher::expiredCount() const
+{
+    return queue_.expiredCount();
+}
+
+/*!
+  \qmlmethod int QxDispatcher::pendingCount()
+
+    Obtain the number of actions in flight or waiting in asynchronous middlewares.
+    A producer may hold back new actions while it is high, and resume on the pendingCountChanged signal.
+
+    \sa QxMiddleware::pendingCount
+ */
+int QxDispatcher::pendingCount() const
+{
+    return hook_.isNull() ? 0 : hook_->pendingCount();
+}
+
 /*!
   \qmlmethod QxDispatcher::waitFor(int listenerId)
   \b{This method is deprecated}
@@ -146,14 +389,21 @@ void QxDispatcher::dispatch(QString type, QJSValue message)
  */
 void QxDispatcher::waitFor(QList<int> ids)
 {
-    if (!is_dispatching_ || ids.size() == 0)
+    if (!is_dispatching_ || ids.size() == 0 || dispatching_slot_ < 0)
         return;
 
-    int id = dispatching_listener_id_;
+    int slot = dispatching_slot_;
+
+    waiting_listeners_.setBit(slot);
+
+    for (int id : std::as_const(ids)) {
+        int target = listeners_.find(id);
+        if (target >= 0) {
+            invokeListener(target);
+        }
+    }
 
-    waiting_listeners_[id] = true;
-    invokeListeners(ids);
-    waiting_listeners_.remove(id);
+    waiting_listeners_.clearBit(slot);
 }
 
 /*!
@@ -177,9 +427,77 @@ int QxDispatcher::addListener(QJSValue callback)
  */
 int QxDispatcher::addListener(QxListener *listener)
 {
-    listeners_[next_listener_id_] = listener;
-    listener->setListenerId(next_listener_id_);
-    return next_listener_id_++;
+    int slot = listeners_.insert(listener);
+    int id = listeners_.id(slot);
+
+    if (pending_listeners_.size() < listeners_.capacity()) {
+        pending_listeners_.resize(listeners_.capacity());
+        waiting_listeners_.resize(listeners_.capacity());
+    }
+
+    listener->setListenerId(id);
+    listener->setDispatcher(this);
+    indexListener(slot);
+
+    if (!acceptWaitFor(listener, listener->waitFor())) {
+        listener->setWaitFor(QList<int>());
+    }
+
+    return id;
+}
+
+/*! \fn void QxDispatcher::updateListenerTypes(QxListener *listener)
+
+    Refresh the types declared by the \a listener. It is private API. Do not use it.
+ */
+void QxDispatcher::updateListenerTypes(QxListener *listener)
+{
+    int slot = listeners_.find(listener->listenerId());
+
+    if (slot < 0 || listeners_.listener(slot) != listener) {
+        return;
+    }
+
+    unindexListener(slot);
+    indexListener(slot);
+}
+
+/*! \fn bool QxDispatcher::acceptWaitFor(QxListener *listener, const QList<int> &wait_for) const
+
+    Return true if the \a listener may wait for the listeners in \a wait_for
+    without creating a cyclic dependency. It is private API. Do not use it.
+ */
+bool QxDispatcher::acceptWaitFor(QxListener *listener, const QList<int> &wait_for) const
+{
+    int slot = listeners_.find(listener->listenerId());
+
+    if (slot < 0 || listeners_.listener(slot) != listener) {
+        return true;
+    }
+
+    QBitArray visited(listeners_.capacity());
+
+    for (int id : wait_for) {
+        int target = listeners_.find(id);
+
+        if (target >= 0 && dependsOn(target, slot, visited)) {
+            qWarning() << "QxAppDispatcher: Cyclic dependency detected. waitFor of listener" << listener->listenerId() << "is rejected.";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*! \fn void QxDispatcher::updateListenerWaitFor(QxListener *listener)
+
+    Refresh the dependencies of the \a listener. It is private API. Do not use it.
+ */
+void QxDispatcher::updateListenerWaitFor(QxListener *listener)
+{
+    Q_UNUSED(listener);
+    plans_.clear();
+    plans_version_++;
 }
 
 /*!
@@ -191,15 +509,43 @@ int QxDispatcher::addListener(QxListener *listener)
 
 void QxDispatcher::removeListener(int id)
 {
-    if (listeners_.contains(id)) {
-        QxListener *listener = listeners_[id].data();
-        if (listener->parent() == this) {
-            listener->deleteLater();
-        }
-        listeners_.remove(id);
+    int slot = listeners_.find(id);
+
+    if (slot < 0) {
+        return;
     }
+
+    QxListener *listener = listeners_.listener(slot);
+    if (listener && listener->parent() == this) {
+        listener->deleteLater();
+    }
+
+    unindexListener(slot);
+    pending_listeners_.clearBit(slot);
+    waiting_listeners_.clearBit(slot);
+    listeners_.remove(slot);
+}
+
+/*!
+    \qmlmethod int QxDispatcher::typeAtom(string type)
+
+    Obtain the atom of an action type. An atom is a small integer interned once per type string
+    and shared by every dispatcher, which is what listeners, filters and scripts use for matching.
+ */
+int QxDispatcher::typeAtom(const QString &type) const
+{
+    return QxAtomTable::intern(type);
 }
 
+/*!
+    \qmlmethod string QxDispatcher::typeName(int atom)
+
+    Obtain the action type of an atom returned by typeAtom(). It returns an empty string for an unknown atom.
+ */
+QString QxDispatcher::typeName(int atom) const
+{
+    return QxAtomTable::name(atom);
+}
 
 /*! \fn QxAppDispatcher::dispatch(const QString &type, const QVariant &message)
 
@@ -207,61 +553,522 @@ void QxDispatcher::removeListener(int id)
     The message will be placed on a queue and delivery via the "dispatched" signal.
     Listeners may listen on the "dispatched" signal directly,
     or using helper components like QxAppListener / QxAppScript to capture signal.
+
+    The message is converted to a JavaScript value only if a JavaScript listener or a middleware receives it,
+    and the converted value is shared by all of them. Native listeners registered by addNativeListener() get the QVariant as is.
  */
 
 void QxDispatcher::dispatch(const QString &type, const QVariant &message)
 {
-    if (engine_.isNull()) {
-        qWarning() << "QxAppDispatcher::dispatch() - Unexpected error: engine is not available.";
+    int atom = QxAtomTable::intern(type);
+
+    if (is_dispatching_) {
+        queue_.enqueue(QxAction(atom, message));
         return;
     }
 
-    QJSValue value = engine_->toScriptValue<QVariant>(message);
+    is_dispatching_ = true;
+    process(QxAction(atom, message));
+    drain();
+    is_dispatching_ = false;
+}
+
+/*! \fn int QxDispatcher::addNativeListener(const QStringList &types, NativeListener listener)
+
+    Register a C++ \a listener for messages with \a types. If \a types is empty, it receives every message.
+    Returns an id for removeNativeListener().
+
+    Native listeners never touch QJSValue. They are invoked after the listeners registered by addListener(),
+    and before the "dispatched" signal is emitted. A message dispatched from JavaScript is converted to QVariant once,
+    only if a native listener receives it.
+
+    \code
+    dispatcher->addNativeListener({"itemAdded"}, [](const QString &type, const QVariant &message) {
+        // ...
+    });
+
+    dispatcher->addNativeListener<QVariantMap>("itemAdded", model, &ItemModel::onItemAdded);
+    \endcode
+ */
+int QxDispatcher::addNativeListener(const QStringList &types, NativeListener listener)
+{
+    int id = next_native_listener_id_++;
+
+    NativeEntry entry;
+    entry.callback = QSharedPointer<NativeListener>::create(std::move(listener));
+    entry.types = QxAtomTable::intern(types);
+
+    std::sort(entry.types.begin(), entry.types.end());
+    entry.types.erase(std::unique(entry.types.begin(), entry.types.end()), entry.types.end());
+
+    if (entry.types.isEmpty()) {
+        native_untyped_listeners_.append(id);
+    } else {
+        for (int atom : std::as_const(entry.types)) {
+            native_type_listeners_[atom].append(id);
+        }
+    }
+
+    native_listeners_.insert(id, entry);
 
-    dispatch(type, value);
+    return id;
 }
 
+/*! \fn void QxDispatcher::removeNativeListener(int id)
 
-void QxDispatcher::send(QString type, QJSValue message)
+    Remove a C++ listener by the \a id returned by addNativeListener(). It is safe to call it from the listener itself.
+ */
+void QxDispatcher::removeNativeListener(int id)
+{
+    auto iter = native_listeners_.find(id);
+
+    if (iter == native_listeners_.end()) {
+        return;
+    }
+
+    if (iter->types.isEmpty()) {
+        native_untyped_listeners_.removeOne(id);
+    }
+
+    for (int atom : std::as_const(iter->types)) {
+        auto ids = native_type_listeners_.find(atom);
+        if (ids == native_type_listeners_.end()) {
+            continue;
+        }
+
+        ids->removeOne(id);
+        if (ids->isEmpty()) {
+            native_type_listeners_.erase(ids);
+        }
+    }
+
+    native_listeners_.erase(iter);
+}
+
+/*! \fn bool QxDispatcher::hasScriptListeners(int atom)
+
+    Return true if a message with the type \a atom would be received by JavaScript,
+    which is a middleware handling the type, a listener or a store declaring the type, or a receiver of the "dispatched" signal.
+    A C++ producer may pass a QVariant to dispatch() if it returns false, and skip building a JavaScript value.
+ */
+bool QxDispatcher::hasScriptListeners(int atom)
+{
+    return (!hook_.isNull() && hook_->hasScriptHandlers(atom)) ||
+           !plan(atom).isEmpty() ||
+           isSignalConnected(dispatchedSignal());
+}
+
+
+/*! \fn void QxDispatcher::post(const QString &type, const QVariant &message)
+
+    Dispatch a message with type from any thread. It is thread-safe.
+
+    The action is placed on a lock-free inbox, and the thread of the dispatcher delivers the inbox in batches.
+    The type is interned on that thread as well, so the caller never waits for a lock.
+    Only a single event is posted to that thread until it has drained the inbox.
+    The message is converted to a JavaScript value on the thread of the dispatcher.
+    Therefore, it must not hold QJSValue or QObject owned by another thread.
+ */
+void QxDispatcher::post(const QString &type, const QVariant &message)
+{
+    inbox_.push(type, message);
+
+    if (!inbox_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, "drainInbox", Qt::QueuedConnection);
+    }
+}
+
+void QxDispatcher::drainInbox()
+{
+    // Cleared before popping. An action pushed from now on schedules another call, or is popped below.
+    inbox_scheduled_.exchange(false, std::memory_order_acq_rel);
+
+    QxInbox::Item item;
+    int count = 0;
+
+    while (count < kInboxBatchSize && inbox_.pop(&item)) {
+        queue_.enqueue(QxAction(QxAtomTable::intern(item.type), item.message));
+        count++;
+    }
+
+    // Check again. The batch may be full, or a producer may still be linking its action.
+    if (!inbox_.isEmpty() && !inbox_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, "drainInbox", Qt::QueuedConnection);
+    }
+
+    if (is_dispatching_) {
+        // It is called from a nested event loop. The actions are delivered by the running dispatch.
+        return;
+    }
+
+    is_dispatching_ = true;
+    drain();
+    is_dispatching_ = false;
+}
+
+void QxDispatcher::process(const QxAction &action)
+{
+    if (hook_.isNull()) {
+        deliver(action);
+    } else {
+        hook_->dispatch(action, engine_.data());
+    }
+}
+
+void QxDispatcher::defer(QObject *context, std::function<void()> callback)
+{
+    if (!is_dispatching_) {
+        callback();
+        return;
+    }
+
+    deferred_.append(DeferredCall{context, std::move(callback)});
+}
+
+void QxDispatcher::drain()
+{
+    QxAction action;
+
+    runDeferred();
+
+    while (queue_.dequeue(&action)) {
+        process(action);
+        runDeferred();
+    }
+}
+
+void QxDispatcher::runDeferred()
 {
-    dispatching_message_ = message;
-    dispatching_message_type_ = type;
-    pending_listeners_.clear();
-    waiting_listeners_.clear();
+    // A callback may defer again. Those callbacks run in the same round.
+    while (!deferred_.isEmpty()) {
+        const QList<DeferredCall> calls = std::exchange(deferred_, QList<DeferredCall>());
 
-    QMapIterator<int, QPointer<QxListener> > iter(listeners_);
-    QList<int> ids;
-    while (iter.hasNext()) {
-        iter.next();
-        pending_listeners_[iter.key()] = true;
-        ids << iter.key();
+        for (const DeferredCall &call : calls) {
+            if (!call.context.isNull()) {
+                call.callback();
+            }
+        }
     }
+}
+
+void QxDispatcher::send(QString type, QJSValue message)
+{
+    deliver(QxAction(QxAtomTable::intern(type), message));
+}
 
-    invokeListeners(ids);
+void QxDispatcher::sendAction(const QxAction &action)
+{
+    deliver(action);
+}
 
-    emit dispatched(type,message);
+void QxDispatcher::deliver(const QxAction &action)
+{
+    deliver(&action, &action + 1, plan(action.atom()));
 }
 
-void QxDispatcher::invokeListeners(QList<int> ids)
+void QxDispatcher::deliver(const QxAction *begin, const QxAction *end, QList<int> indices)
 {
-    for (int i = 0 ; i < ids.size() ; i++) {
-        int next = ids.at(i);
+    // A delivery may be nested in a listener, e.g. by a deferred middleware calling next().
+    // The state of the outer delivery is restored afterwards.
+    const QxAction previous_action = dispatching_action_;
+    const int previous_slot = dispatching_slot_;
+    QBitArray previous_pending;
+
+    if (!previous_action.isNull()) {
+        previous_pending = pending_listeners_;
+        pending_listeners_.fill(false);
+    }
 
-        if (waiting_listeners_.contains(next)) {
-            qWarning() << "QxAppDispatcher: Cyclic dependency detected";
+    quint64 plans_version = plans_version_;
+
+    for (const QxAction *action = begin ; action != end ; action++) {
+        if (action != begin) {
+            // Callbacks deferred by the previous action of the run.
+            runDeferred();
+
+            if (plans_version != plans_version_) {
+                // Listeners have changed. The held plan may name a reused slot.
+                indices = plan(action->atom());
+                plans_version = plans_version_;
+            }
+        }
+
+        // The canonical string of the atom, so downstream lookups are resolved by identity.
+        const QString type = action->type();
+
+        if (indices.isEmpty()) {
+            if (!native_listeners_.isEmpty()) {
+                invokeNativeListeners(*action);
+            }
+        } else {
+            dispatching_action_ = *action;
+
+            for (int slot : std::as_const(indices)) {
+                pending_listeners_.setBit(slot);
+            }
+
+            // Trailing listeners, i.e. bound stores, come last in the plan. They follow the native listeners.
+            const auto trailing = std::find_if(indices.constBegin(), indices.constEnd(), [this](int slot) {
+                return listeners_.at(slot).trailing;
+            });
+
+            invokeListeners(indices.constBegin(), trailing);
+
+            if (!native_listeners_.isEmpty()) {
+                invokeNativeListeners(*action);
+            }
+
+            invokeListeners(trailing, indices.constEnd());
+        }
+
+        QJSValue message;
+
+        if (action->isMaterialized() || isSignalConnected(dispatchedSignal())) {
+            message = action->message(engine_.data());
         }
 
-        if (!pending_listeners_.contains(next))
+        emit dispatched(type,message);
+    }
+
+    if (!previous_action.isNull()) {
+        // Listeners may have been added meanwhile.
+        previous_pending.resize(pending_listeners_.size());
+        pending_listeners_ = previous_pending;
+    }
+
+    dispatching_slot_ = previous_slot;
+    dispatching_action_ = previous_action;
+}
+
+void QxDispatcher::invokeListeners(QList<int>::const_iterator begin, QList<int>::const_iterator end)
+{
+    for (auto iter = begin ; iter != end ; iter++) {
+        invokeListener(*iter);
+    }
+}
+
+void QxDispatcher::invokeListener(int slot)
+{
+    if (waiting_listeners_.testBit(slot)) {
+        qWarning() << "QxAppDispatcher: Cyclic dependency detected";
+    }
+
+    if (!pending_listeners_.testBit(slot))
+        return;
+
+    pending_listeners_.clearBit(slot);
+
+    QxListener *listener = listeners_.listener(slot);
+
+    if (listener) {
+        int previous = dispatching_slot_;
+        dispatching_slot_ = slot;
+        // The message is built by the first listener which receives it, and shared by the rest.
+        listener->dispatch(dispatching_action_.atom(), dispatching_action_.type(), dispatching_action_.message(engine_.data()));
+        dispatching_slot_ = previous;
+    }
+}
+
+void QxDispatcher::indexListener(int slot)
+{
+    auto insert = [this, slot](QList<int> &indices) {
+        auto pos = std::lower_bound(indices.begin(), indices.end(), slot, [this](int a, int b) {
+            return listeners_.order(a) < listeners_.order(b);
+        });
+        indices.insert(pos, slot);
+    };
+
+    QxListenerRegistry::Slot &entry = listeners_.at(slot);
+    QxListener *listener = entry.listener.data();
+
+    plans_.clear();
+    plans_version_++;
+    entry.trailing = listener && listener->isTrailing();
+
+    if (!listener || !listener->hasTypes()) {
+        entry.typed = false;
+        insert(untyped_listeners_);
+        return;
+    }
+
+    QList<int> types = listener->types();
+    types.removeAll(0);
+    std::sort(types.begin(), types.end());
+    types.erase(std::unique(types.begin(), types.end()), types.end());
+
+    for (int atom : std::as_const(types)) {
+        insert(type_listeners_[atom]);
+    }
+
+    entry.typed = true;
+    entry.types = types;
+}
+
+void QxDispatcher::unindexListener(int slot)
+{
+    QxListenerRegistry::Slot &entry = listeners_.at(slot);
+
+    plans_.clear();
+    plans_version_++;
+
+    if (!entry.typed) {
+        untyped_listeners_.removeOne(slot);
+        return;
+    }
+
+    for (int atom : std::as_const(entry.types)) {
+        auto entries = type_listeners_.find(atom);
+        if (entries == type_listeners_.end()) {
             continue;
+        }
+
+        entries->removeOne(slot);
+        if (entries->isEmpty()) {
+            type_listeners_.erase(entries);
+        }
+    }
+
+    entry.typed = false;
+    entry.types.clear();
+}
+
+QList<int> QxDispatcher::plan(int atom)
+{
+    auto iter = plans_.constFind(atom);
+
+    if (iter != plans_.constEnd()) {
+        return iter.value();
+    }
+
+    QList<int> indices;
+    auto typed = type_listeners_.constFind(atom);
+
+    if (typed == type_listeners_.constEnd()) {
+        indices = untyped_listeners_;
+    } else {
+        indices.reserve(typed->size() + untyped_listeners_.size());
+        std::merge(typed->constBegin(), typed->constEnd(),
+                   untyped_listeners_.constBegin(), untyped_listeners_.constEnd(),
+                   std::back_inserter(indices), [this](int a, int b) {
+            return listeners_.order(a) < listeners_.order(b);
+        });
+    }
+
+    // Listeners waiting for a listener which doesn't receive this type are not affected.
+    QBitArray members(listeners_.capacity());
+    QBitArray visited(listeners_.capacity());
+
+    for (int slot : std::as_const(indices)) {
+        members.setBit(slot);
+    }
 
-        pending_listeners_.remove(next);
-        dispatching_listener_id_ = next;
+    QList<int> result;
+    result.reserve(indices.size());
 
-        QxListener *listener = listeners_[next].data();
+    for (int slot : std::as_const(indices)) {
+        appendToPlan(slot, members, visited, result);
+    }
+
+    // Trailing listeners are not waited for, so moving them last keeps the order of the others.
+    std::stable_partition(result.begin(), result.end(), [this](int slot) {
+        return !listeners_.at(slot).trailing;
+    });
+
+    plans_.insert(atom, result);
+
+    return result;
+}
+
+void QxDispatcher::appendToPlan(int slot, const QBitArray &members, QBitArray &visited, QList<int> &plan) const
+{
+    if (visited.testBit(slot)) {
+        return;
+    }
+
+    visited.setBit(slot);
+
+    QxListener *listener = listeners_.listener(slot);
+
+    if (listener) {
+        const QList<int> wait_for = listener->waitFor();
+
+        for (int id : wait_for) {
+            int dependency = listeners_.find(id);
+            if (dependency >= 0 && members.testBit(dependency)) {
+                appendToPlan(dependency, members, visited, plan);
+            }
+        }
+    }
+
+    plan.append(slot);
+}
+
+bool QxDispatcher::dependsOn(int from, int target, QBitArray &visited) const
+{
+    if (from == target) {
+        return true;
+    }
+
+    if (visited.testBit(from)) {
+        return false;
+    }
+
+    visited.setBit(from);
 
-        if (listener) {
-            listener->dispatch(this,dispatching_message_type_,dispatching_message_);
+    QxListener *listener = listeners_.listener(from);
+
+    if (!listener) {
+        return false;
+    }
+
+    const QList<int> wait_for = listener->waitFor();
+
+    for (int id : wait_for) {
+        int dependency = listeners_.find(id);
+        if (dependency >= 0 && dependsOn(dependency, target, visited)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void QxDispatcher::invokeNativeListeners(const QxAction &action)
+{
+    const int atom = action.atom();
+
+    static const QList<int> empty;
+
+    // Hold copies. Listeners may be added or removed by a callback.
+    const QList<int> typed = native_type_listeners_.value(atom, empty);
+    const QList<int> untyped = native_untyped_listeners_;
+
+    if (typed.isEmpty() && untyped.isEmpty()) {
+        return;
+    }
+
+    const QString type = action.type();
+    const QVariant value = action.payload();
+
+    int i = 0;
+    int j = 0;
+
+    // Merge both lists by id, which is the registration order.
+    while (i < typed.size() || j < untyped.size()) {
+        int id;
+        if (j >= untyped.size() || (i < typed.size() && typed.at(i) < untyped.at(j))) {
+            id = typed.at(i++);
+        } else {
+            id = untyped.at(j++);
+        }
+
+        auto iter = native_listeners_.constFind(id);
+        if (iter == native_listeners_.constEnd()) {
+            continue;
         }
+
+        QSharedPointer<NativeListener> callback = iter->callback;
+        (*callback)(type, value);
     }
 }
 
@@ -280,8 +1087,12 @@ void QxDispatcher::setHook(QxHook *hook)
 
     if (!hook_.isNull()) {
         connect(hook_.data(), SIGNAL(dispatched(QString,QJSValue)), this,SLOT(send(QString,QJSValue)));
+        connect(hook_.data(), SIGNAL(actionDispatched(QxAction)), this,SLOT(sendAction(QxAction)));
+        connect(hook_.data(), SIGNAL(pendingCountChanged()), this, SIGNAL(pendingCountChanged()));
     }
 
+    emit pendingCountChanged();
+
 }
 
 /*! \fn QQmlEngine *QxAppDispatcher::engine() const
@@ -304,4 +1115,5 @@ QQmlEngine *QxDispatcher::engine() const
 void QxDispatcher::setEngine(QQmlEngine *engine)
 {
     engine_ = engine;
+    queue_.setEngine(engine);
 }
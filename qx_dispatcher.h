@@ -1,15 +1,22 @@
 #ifndef QX_DISPATCHER_H
 #define QX_DISPATCHER_H
 
+#include <atomic>
+#include <functional>
 #include <QObject>
 #include <QVariantMap>
 #include <QJSValue>
-#include <QQueue>
 #include <QPair>
 #include <QQmlEngine>
 #include <QPointer>
+#include <QBitArray>
+#include <QSharedPointer>
 
 #include "private/qx_listener.h"
+#include "private/qx_listener_registry.h"
+#include "private/qx_action.h"
+#include "private/qx_action_queue.h"
+#include "private/qx_inbox.h"
 #include "private/qx_hook.h"
 
 class QxDispatcher : public QObject
@@ -17,12 +24,62 @@ class QxDispatcher : public QObject
     Q_OBJECT
     QML_ELEMENT
 public:
+    enum CoalescePolicy {
+        KeepAll = QxActionQueue::KeepAll,
+        LatestWins = QxActionQueue::LatestWins,
+        Merge = QxActionQueue::Merge
+    };
+    Q_ENUM(CoalescePolicy)
+
+    enum Priority {
+        HighPriority = QxActionQueue::HighLane,
+        NormalPriority = QxActionQueue::NormalLane,
+        LowPriority = QxActionQueue::LowLane
+    };
+    Q_ENUM(Priority)
+
     explicit QxDispatcher(QObject *parent = nullptr);
 
     void dispatch(const QString &type, const QVariant &message);
 
+    void dispatchBatch(const QList<QPair<QString, QVariant>> &actions);
+
+    void post(const QString &type, const QVariant &message = QVariant());
+
+    using NativeListener = std::function<void(const QString &type, const QVariant &message)>;
+
+    /// Register a C++ callback receiving messages as QVariant. If types is empty, it receives every message.
+    int addNativeListener(const QStringList &types, NativeListener listener);
+
+    /// Register a member function receiving the message of type converted to T.
+    template <typename T, typename Object>
+    int addNativeListener(const QString &type, Object *object, void (Object::*method)(const T &))
+    {
+        QPointer<Object> guard(object);
+        return addNativeListener(QStringList() << type, [guard, method](const QString &, const QVariant &message) {
+            if (!guard.isNull()) {
+                (guard.data()->*method)(message.value<T>());
+            }
+        });
+    }
+
+    void removeNativeListener(int id);
+
+    /// Run callback once the action being dispatched has been delivered, or now if the dispatcher is idle.
+    /// It is skipped if context is destroyed before.
+    void defer(QObject *context, std::function<void()> callback);
+
+    /// Return true if a message of type atom would reach JavaScript: a middleware, a listener, a store or a receiver of dispatched.
+    bool hasScriptListeners(int atom);
+
     int addListener(QxListener *listener);
 
+    void updateListenerTypes(QxListener *listener);
+
+    bool acceptWaitFor(QxListener *listener, const QList<int> &wait_for) const;
+
+    void updateListenerWaitFor(QxListener *listener);
+
     QQmlEngine *engine() const;
 
     void setEngine(QQmlEngine *engine);
@@ -46,53 +103,152 @@ public slots:
     */
     Q_INVOKABLE void dispatch(QString type, QJSValue message = QJSValue());
 
+    Q_INVOKABLE void dispatchWithOptions(QString type, QJSValue message, QJSValue options);
+
+    Q_INVOKABLE void dispatchBatch(const QJSValue &actions);
+
+    Q_INVOKABLE void setCoalescePolicy(const QString &type, QxDispatcher::CoalescePolicy policy, const QJSValue &merge = QJSValue());
+
+    Q_INVOKABLE void setTypePriority(const QString &type, QxDispatcher::Priority priority);
+
+    Q_INVOKABLE int queueDepth(QxDispatcher::Priority priority) const;
+
+    Q_INVOKABLE int expiredCount() const;
+
+    Q_INVOKABLE int pendingCount() const;
+
     Q_INVOKABLE void waitFor(QList<int> ids);
 
     Q_INVOKABLE int addListener(QJSValue callback);
 
     Q_INVOKABLE void removeListener(int id);
 
+    Q_INVOKABLE int typeAtom(const QString &type) const;
+
+    Q_INVOKABLE QString typeName(int atom) const;
+
 private:
-    void invokeListeners(QList<int> ids);
+    struct NativeEntry
+    {
+        QSharedPointer<NativeListener> callback;
+        QList<int> types;
+    };
+
+    // Deliver actions in order, bypassing priorities and coalescing. They are queued if the dispatcher is busy.
+    // An action handled by the hook runs through the middlewares on its own. Consecutive actions the hook would
+    // only pass on, and which reach the same listeners, are delivered as a run with one plan lookup.
+    void dispatchActions(const QList<QxAction> &actions);
+
+    // Pass an action to the hook, or deliver it if there is no hook.
+    void process(const QxAction &action);
+
+    // Deliver an action to listeners. A native payload is only converted if a JavaScript consumer receives it.
+    void deliver(const QxAction &action);
+
+    // Deliver the actions from begin to end, which share the plan indices. The state of an outer delivery is
+    // saved once for the run. Deferred callbacks are run between the actions.
+    void deliver(const QxAction *begin, const QxAction *end, QList<int> indices);
+
+    void invokeNativeListeners(const QxAction &action);
+
+    // Process queued actions until the queue is empty. Deferred callbacks are run after each action.
+    void drain();
+
+    void runDeferred();
+
+    void invokeListeners(QList<int>::const_iterator begin, QList<int>::const_iterator end);
+
+    void invokeListener(int slot);
+
+    void indexListener(int slot);
+
+    void unindexListener(int slot);
+
+    // Obtain the slots of listeners which should receive a message of type atom.
+    // Listeners follow registration order, but are placed after the listeners they wait for.
+    QList<int> plan(int atom);
+
+    void appendToPlan(int slot, const QBitArray &members, QBitArray &visited, QList<int> &plan) const;
+
+    // Return true if the listener in slot from waits for target, directly or not.
+    bool dependsOn(int from, int target, QBitArray &visited) const;
 
     bool is_dispatching_;
 
     QPointer<QQmlEngine> engine_;
 
     // Queue for dispatching messages
-    QQueue<QPair<QString, QJSValue>> queue_;
+    QxActionQueue queue_;
+
+    // Registered listeners
+    QxListenerRegistry listeners_;
 
-    // Next id for listener.
-    int next_listener_id_;
+    // Slots of listeners that declared their types, keyed by type atom. Kept in registration order.
+    QHash<int, QList<int>> type_listeners_;
 
-    // Registered listener
-    QMap<int, QPointer<QxListener>> listeners_;
+    // Slots of listeners that did not declare their types. They receive every message.
+    QList<int> untyped_listeners_;
 
-    // Current dispatching listener id
-    int dispatching_listener_id_;
+    // Slots to invoke per type atom. Rebuilt on demand after listeners or their dependencies have changed.
+    QHash<int, QList<int>> plans_;
 
-    // Current dispatching message
-    QJSValue dispatching_message_;
+    // Incremented whenever plans_ is dropped
+    quint64 plans_version_;
 
-    // Current dispatching message type
-    QString dispatching_message_type_;
+    // C++ listeners, keyed by id. Ids are ascending in registration order.
+    QHash<int, NativeEntry> native_listeners_;
 
-    // List of listeners pending to be invoked.
-    QMap<int, bool> pending_listeners_;
+    QHash<int, QList<int>> native_type_listeners_;
 
-    // List of listeners blocked in waitFor()
-    QMap<int, bool> waiting_listeners_;
+    QList<int> native_untyped_listeners_;
+
+    int next_native_listener_id_;
+
+    // Slot of the current dispatching listener
+    int dispatching_slot_;
+
+    // Current dispatching action. Its message is materialized by the first listener invoked.
+    QxAction dispatching_action_;
+
+    // Listeners pending to be invoked, by slot.
+    QBitArray pending_listeners_;
+
+    // Listeners blocked in waitFor(), by slot.
+    QBitArray waiting_listeners_;
 
     QPointer<QxHook> hook_;
 
+    struct DeferredCall
+    {
+        QPointer<QObject> context;
+        std::function<void()> callback;
+    };
+
+    // Callbacks passed to defer() while dispatching
+    QList<DeferredCall> deferred_;
+
+    // Actions posted from any thread
+    QxInbox inbox_;
+
+    // True if a drainInbox() call is pending in the event loop
+    std::atomic<bool> inbox_scheduled_;
+
 private slots:
+    // Deliver the actions posted to the inbox
+    void drainInbox();
+
     // Invoke listener and emit the dispatched signal
     void send(QString type, QJSValue message);
 
+    void sendAction(const QxAction &action);
+
 signals:
     // This signal is emitted when a message is ready to dispatch by QxAppDispatcher.
     Q_SIGNAL void dispatched(QString type, QJSValue message);
 
+    // This signal is emitted when the number of actions held by middlewares has changed.
+    void pendingCountChanged();
+
 };
 
 #endif // QX_DISPATCHER_H
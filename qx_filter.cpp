@@ -3,7 +3,11 @@
 #include <QtQml>
 
 #include "qx_filter.h"
+#include "qx_app_listener.h"
+#include "qx_store.h"
 #include "private/quix_functions.h"
+#include "private/qx_atom_table.h"
+#include "private/qx_filter_index.h"
 
 /*!
     \qmltype QxFilter
@@ -42,6 +46,9 @@
 
     In contrast, QxFilter share the same listenerId with its parent,
     and therefore it is a solution for above problem.
+
+    A QxStore or QxAppListener parent keeps its filters indexed by type and invokes the matching ones only.
+    With any other parent, QxFilter listens to the parent's dispatched signal.
 */
 
 /*! \qmlsignal Filter::dispatched(string type, object message)
@@ -85,6 +92,7 @@ QString QxFilter::type() const
 void QxFilter::setType(const QString &type)
 {
     types_ = QStringList() << type;
+    atoms_ = QxAtomTable::intern(types_);
     emit typeChanged();
     emit typesChanged();
 }
@@ -114,6 +122,9 @@ QStringList QxFilter::types() const
 void QxFilter::setTypes(const QStringList &types)
 {
     types_ = types;
+    atoms_ = QxAtomTable::intern(types_);
+    emit typeChanged();
+    emit typesChanged();
 }
 
 QQmlListProperty<QObject> QxFilter::children()
@@ -121,6 +132,17 @@ QQmlListProperty<QObject> QxFilter::children()
     return QQmlListProperty<QObject>(qobject_cast<QObject *>(this), &children_);
 }
 
+QList<int> QxFilter::atoms() const
+{
+    return atoms_;
+}
+
+void QxFilter::deliver(const QString &type, const QJSValue &message)
+{
+    QX_PRECHECK_DISPATCH(engine_.data(), type, message);
+    emit dispatched(type, message);
+}
+
 void QxFilter::classBegin()
 {
     // Intentionally left empty.
@@ -136,6 +158,18 @@ void QxFilter::componentComplete()
         return;
     }
 
+    QxStore *store = qobject_cast<QxStore *>(object);
+    if (store) {
+        store->filterIndex()->add(this);
+        return;
+    }
+
+    QxAppListener *listener = qobject_cast<QxAppListener *>(object);
+    if (listener) {
+        listener->filterIndex()->add(this);
+        return;
+    }
+
     const QMetaObject *meta = object->metaObject();
 
     if (meta->indexOfSignal("dispatched(QString,QJSValue)") >= 0) {
@@ -148,17 +182,17 @@ void QxFilter::componentComplete()
     }
 }
 
-void QxFilter::filter(QString type, QJSValue message)
+void QxFilter::filter(const QString &type, const QJSValue &message)
 {
-    if (types_.indexOf(type) >= 0) {
+    if (atoms_.contains(QxAtomTable::lookup(type))) {
         QX_PRECHECK_DISPATCH(engine_.data(), type, message);
         emit dispatched(type, message);
     }
 }
 
-void QxFilter::filter(QString type, QVariant message)
+void QxFilter::filter(const QString &type, const QVariant &message)
 {
-    if (types_.indexOf(type) >= 0) {
+    if (atoms_.contains(QxAtomTable::lookup(type))) {
         QJSValue value = message.value<QJSValue>();
         QX_PRECHECK_DISPATCH(engine_.data(), type, value);
 
@@ -32,18 +32,25 @@ public:
 
     QQmlListProperty<QObject> children();
 
+    /// The atoms of types.
+    QList<int> atoms() const;
+
+    /// Emit the dispatched signal. It is called by the parent store or listener for a matched message.
+    void deliver(const QString &type, const QJSValue &message);
+
 protected:
     void classBegin();
     void componentComplete();
 
 private:
     QStringList types_;
+    QList<int> atoms_;
     QList<QObject *> children_;
     QPointer<QQmlEngine> engine_;
 
 private slots:
-    void filter(QString type, QJSValue message);
-    void filter(QString type, QVariant message);
+    void filter(const QString &type, const QJSValue &message);
+    void filter(const QString &type, const QVariant &message);
 
 signals:
     void dispatched(QString type, QJSValue message);
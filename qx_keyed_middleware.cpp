@@ -0,0 +1,192 @@
+#include <QCborArray>
+#include <QCborMap>
+#include <QMetaProperty>
+
+#include "qx_keyed_middleware.h"
+#include "private/qx_atom_table.h"
+
+namespace {
+
+// A tag marking the address of a QObject, so it never equals a string.
+const QCborTag ObjectTag = QCborTag(0x5158);
+
+bool keyValue(const QVariant &value, QCborValue *result)
+{
+    const QMetaType type = value.metaType();
+
+    switch (type.id()) {
+    case QMetaType::UnknownType:
+        *result = QCborValue();
+        return true;
+    case QMetaType::QVariantMap:
+    case QMetaType::QVariantHash: {
+        // Written in the order of names, so a hash has the same key as a map.
+        const QVariantMap map = value.toMap();
+        QCborMap items;
+
+        for (auto iter = map.constBegin() ; iter != map.constEnd() ; iter++) {
+            QCborValue item;
+            if (!keyValue(iter.value(), &item)) {
+                return false;
+            }
+            items.insert(iter.key(), item);
+        }
+
+        *result = items;
+        return true;
+    }
+    case QMetaType::QVariantList:
+    case QMetaType::QStringList: {
+        const QVariantList list = value.toList();
+        QCborArray items;
+
+        for (const QVariant &element : list) {
+            QCborValue item;
+            if (!keyValue(element, &item)) {
+                return false;
+            }
+            items.append(item);
+        }
+
+        *result = items;
+        return true;
+    }
+    default:
+        break;
+    }
+
+    if (type.flags() & QMetaType::PointerToQObject) {
+        *result = QCborValue(ObjectTag, qint64(quintptr(value.value<QObject *>())));
+        return true;
+    }
+
+    // Numbers are compared as strings, so 1 from C++ and 1.0 from JavaScript are equal.
+    if (value.canConvert<QString>()) {
+        *result = value.toString();
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+/*! \class QxKeyedMiddleware
+    \brief Base class of native middlewares keeping state per action type and key
+
+    The types property selects the actions it applies to. If it is empty, every action is affected.
+    The keyPath property is a dot separated path into the message, e.g. "item.id".
+    Actions with a different value at the path are handled independently. Objects are compared by identity.
+    An action whose value has no key, e.g. a gadget without a conversion to string, is passed on untouched.
+ */
+
+QxKeyedMiddleware::QxKeyedMiddleware(QQuickItem *parent)
+    : QxNativeMiddleware{parent}
+    , interval_(100)
+{
+    // Intentionally left empty.
+}
+
+QStringList QxKeyedMiddleware::types() const
+{
+    return types_;
+}
+
+void QxKeyedMiddleware::setTypes(const QStringList &types)
+{
+    types_ = types;
+    atoms_ = QxAtomTable::intern(types);
+    emit typesChanged();
+}
+
+QString QxKeyedMiddleware::keyPath() const
+{
+    return key_path_;
+}
+
+void QxKeyedMiddleware::setKeyPath(const QString &key_path)
+{
+    key_path_ = key_path;
+    key_path_parts_ = key_path.split(QLatin1Char('.'), Qt::SkipEmptyParts);
+    emit keyPathChanged();
+}
+
+int QxKeyedMiddleware::interval() const
+{
+    return interval_;
+}
+
+void QxKeyedMiddleware::setInterval(int interval)
+{
+    if (interval_ == interval) {
+        return;
+    }
+
+    interval_ = interval;
+    emit intervalChanged();
+}
+
+bool QxKeyedMiddleware::accepts(const QxAction &action) const
+{
+    return atoms_.isEmpty() || atoms_.contains(action.atom());
+}
+
+bool QxKeyedMiddleware::keyOf(const QxAction &action, Key *key) const
+{
+    key->first = action.atom();
+    key->second.clear();
+
+    if (key_path_parts_.isEmpty()) {
+        return true;
+    }
+
+    return encodeKey(valueAt(action, key_path_parts_), &key->second);
+}
+
+QVariant QxKeyedMiddleware::valueAt(const QxAction &action, const QStringList &path)
+{
+    if (action.isMaterialized()) {
+        QJSValue value = action.message(nullptr);
+
+        for (const QString &name : path) {
+            value = value.property(name);
+        }
+
+        return value.toVariant();
+    }
+
+    QVariant value = action.payload();
+
+    for (const QString &name : path) {
+        const QMetaType type = value.metaType();
+
+        if (type.id() == QMetaType::QVariantMap) {
+            value = value.toMap().value(name);
+        } else if (type.id() == QMetaType::QVariantHash) {
+            value = value.toHash().value(name);
+        } else if (type.flags() & QMetaType::PointerToQObject) {
+            QObject *object = value.value<QObject *>();
+            value = object ? object->property(name.toUtf8().constData()) : QVariant();
+        } else if ((type.flags() & QMetaType::IsGadget) && type.metaObject()) {
+            const QMetaObject *meta = type.metaObject();
+            const int index = meta->indexOfProperty(name.toUtf8().constData());
+            value = index >= 0 ? meta->property(index).readOnGadget(value.constData()) : QVariant();
+        } else {
+            return QVariant();
+        }
+    }
+
+    return value;
+}
+
+bool QxKeyedMiddleware::encodeKey(const QVariant &value, QByteArray *key)
+{
+    QCborValue result;
+
+    if (!keyValue(value, &result)) {
+        return false;
+    }
+
+    *key = result.toCbor();
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef QX_KEYED_MIDDLEWARE_H
+#define QX_KEYED_MIDDLEWARE_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QStringList>
+
+#include "qx_native_middleware.h"
+
+/// QxKeyedMiddleware is the base of native middlewares keeping state per action type and key,
+/// like QxThrottle, QxDebounce and QxDedupe.
+class QxKeyedMiddleware : public QxNativeMiddleware
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList types READ types WRITE setTypes NOTIFY typesChanged)
+    Q_PROPERTY(QString keyPath READ keyPath WRITE setKeyPath NOTIFY keyPathChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    QML_ANONYMOUS
+public:
+    explicit QxKeyedMiddleware(QQuickItem *parent = nullptr);
+
+    QStringList types() const;
+    void setTypes(const QStringList &types);
+
+    QString keyPath() const;
+    void setKeyPath(const QString &key_path);
+
+    int interval() const;
+    void setInterval(int interval);
+
+protected:
+    using Key = QPair<int, QByteArray>;
+
+    /// Return true if the middleware applies to the action. Others are passed on untouched.
+    bool accepts(const QxAction &action) const;
+
+    /// Obtain the type atom of the action, and the value at keyPath in its message. The value is empty if keyPath is not set.
+    /// Returns false if the value has no key. Such an action should be passed on.
+    bool keyOf(const QxAction &action, Key *key) const;
+
+    /// Read the value at path from the message. The JavaScript message is read if it is available, the payload otherwise.
+    static QVariant valueAt(const QxAction &action, const QStringList &path);
+
+    /// Encode a value as a key. Maps and lists are encoded by their items, QObjects by identity, and other values by
+    /// their string conversion. Returns false if value has none, e.g. a gadget without a converter to QString.
+    static bool encodeKey(const QVariant &value, QByteArray *key);
+
+signals:
+    void typesChanged();
+    void keyPathChanged();
+    void intervalChanged();
+
+private:
+    QStringList types_;
+    QList<int> atoms_;
+    QString key_path_;
+    QStringList key_path_parts_;
+    int interval_;
+};
+
+#endif // QX_KEYED_MIDDLEWARE_H
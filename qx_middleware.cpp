@@ -1,5 +1,7 @@
 #include "qx_middleware.h"
 #include "private/quix_functions.h"
+#include "private/qx_atom_table.h"
+#include "private/qx_middlewares_hook.h"
 
 /*!
     \qmltype QxMiddleware
@@ -66,6 +68,10 @@
 QxMiddleware::QxMiddleware(QQuickItem *parent)
     : QQuickItem{parent}
     , filter_function_enabled_(false)
+    , ordered_(true)
+    , max_concurrency_(0)
+    , pending_count_(0)
+    , index_(-1)
 {
     // Intentionally left empty.
 }
@@ -81,6 +87,168 @@ void QxMiddleware::setNextCallback(const QJSValue &next_callback)
     emit _nextCallbackChanged();
 }
 
+bool QxMiddleware::filterFunctionEnabled() const
+{
+    return filter_function_enabled_;
+}
+
+/*! \qmlproperty string QxMiddleware::filter
+    If it is set, the "dispatch" function is only invoked for actions with this type.
+    Other actions are passed to the next middleware without entering this one.
+    Filter functions enabled by filterFunctionEnabled are not affected.
+
+    \code
+        QxMiddleware {
+            filter: ActionTypes.removeItem
+
+            function dispatch(type, message) {
+                // Only ActionTypes.removeItem arrives here
+                next(type, message);
+            }
+        }
+    \endcode
+
+    \sa QxMiddleware::types
+ */
+
+QString QxMiddleware::filter() const
+{
+    return filter_;
+}
+
+void QxMiddleware::setFilter(const QString &filter)
+{
+    filter_ = filter;
+    updateAtoms();
+    emit filterChanged();
+}
+
+/*! \qmlproperty array QxMiddleware::types
+    A list of types the "dispatch" function is invoked for. It works like QxMiddleware::filter.
+    If neither of them is set, every action is passed to the "dispatch" function.
+
+    \sa QxMiddleware::filter
+ */
+
+QStringList QxMiddleware::types() const
+{
+    return types_;
+}
+
+void QxMiddleware::setTypes(const QStringList &types)
+{
+    types_ = types;
+    updateAtoms();
+    emit typesChanged();
+}
+
+/*! \qmlproperty bool QxMiddleware::ordered
+    A "dispatch" or filter function may return a Promise. The action stays in flight in the middleware
+    until the Promise is settled, and the function is expected to call next() before that.
+
+    If this property is true, the middleware holds one action in flight at a time.
+    Later actions wait in the middleware, so they could not overtake an earlier one.
+    If it is false, up to maxConcurrency actions are in flight, and they may complete in any order.
+
+    \code
+        QxMiddleware {
+            filter: ActionTypes.saveItem
+
+            async function dispatch(type, message) {
+                await storage.save(message);
+                next(type, message);
+            }
+        }
+    \endcode
+
+    The default value is true.
+
+    \sa QxMiddleware::maxConcurrency, QxMiddleware::pendingCount
+ */
+
+bool QxMiddleware::ordered() const
+{
+    return ordered_;
+}
+
+void QxMiddleware::setOrdered(bool ordered)
+{
+    if (ordered_ == ordered) {
+        return;
+    }
+
+    ordered_ = ordered;
+    emit orderedChanged();
+}
+
+/*! \qmlproperty int QxMiddleware::maxConcurrency
+    The number of actions which may be in flight in the middleware at the same time if ordered is false.
+    Further actions wait in the middleware until one of them is settled.
+    0 means no limit.
+
+    The default value is 0.
+ */
+
+int QxMiddleware::maxConcurrency() const
+{
+    return max_concurrency_;
+}
+
+void QxMiddleware::setMaxConcurrency(int max_concurrency)
+{
+    if (max_concurrency_ == max_concurrency) {
+        return;
+    }
+
+    max_concurrency_ = max_concurrency;
+    emit maxConcurrencyChanged();
+}
+
+/*! \qmlproperty int QxMiddleware::pendingCount
+    The number of actions in flight or waiting in the middleware. It is read-only.
+    The total of a dispatcher is returned by QxDispatcher::pendingCount().
+ */
+
+int QxMiddleware::pendingCount() const
+{
+    return pending_count_;
+}
+
+void QxMiddleware::setPendingCount(int pending_count)
+{
+    if (pending_count_ == pending_count) {
+        return;
+    }
+
+    pending_count_ = pending_count;
+    emit pendingCountChanged();
+}
+
+bool QxMiddleware::hasTypes() const
+{
+    return !atoms_.isEmpty();
+}
+
+QList<int> QxMiddleware::atoms() const
+{
+    return atoms_;
+}
+
+void QxMiddleware::updateAtoms()
+{
+    atoms_ = QxAtomTable::intern(types_);
+
+    if (!filter_.isEmpty()) {
+        atoms_.append(QxAtomTable::intern(filter_));
+    }
+}
+
+void QxMiddleware::setChain(QxMiddlewaresHook *hook, int index)
+{
+    hook_ = hook;
+    index_ = index;
+}
+
 /*! \qmlmethod QxMiddleware::next(string type, object message)
     Pass an action message to next middleware. If it is already the last middleware, the action will be dispatched to QxStore component.
  */
@@ -88,7 +256,7 @@ void QxMiddleware::setNextCallback(const QJSValue &next_callback)
 /*! \qmlproperty bool QxMiddleware::filterFunctionEnabled
     If this property is true, whatever the middleware component received a new action.
     Beside to invoke a dispatch signal, it will search for a function with a name as the action.
-    If it exists, it will call also call the function.
+    If it exists, it will call also call the function. Signals and the methods of QxMiddleware itself are not filter functions.
 
     \code
         Middleware {
@@ -109,6 +277,11 @@ void QxMiddleware::next(QString type, QJSValue message)
     QQmlEngine* engine = qmlEngine(this);
     QX_PRECHECK_DISPATCH(engine, type, message);
 
+    if (!hook_.isNull()) {
+        hook_->next(index_, type, message);
+        return;
+    }
+
     if (next_callback_.isCallable()) {
         QJSValueList args;
         args << type;
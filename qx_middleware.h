@@ -3,11 +3,19 @@
 
 #include <QQuickItem>
 #include <QJSValue>
+#include <QPointer>
+
+class QxMiddlewaresHook;
 
 class QxMiddleware : public QQuickItem
 {
     Q_OBJECT
     Q_PROPERTY(bool filterFunctionEnabled MEMBER filter_function_enabled_ NOTIFY filterFunctionEnabledChanged)
+    Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged)
+    Q_PROPERTY(QStringList types READ types WRITE setTypes NOTIFY typesChanged)
+    Q_PROPERTY(bool ordered READ ordered WRITE setOrdered NOTIFY orderedChanged)
+    Q_PROPERTY(int maxConcurrency READ maxConcurrency WRITE setMaxConcurrency NOTIFY maxConcurrencyChanged)
+    Q_PROPERTY(int pendingCount READ pendingCount NOTIFY pendingCountChanged)
     Q_PROPERTY(QJSValue _nextCallback READ nextCallback WRITE setNextCallback NOTIFY _nextCallbackChanged)
     QML_ELEMENT
 public:
@@ -16,16 +24,59 @@ public:
     QJSValue nextCallback() const;
     void setNextCallback(const QJSValue &next_callback);
 
+    bool filterFunctionEnabled() const;
+
+    QString filter() const;
+    void setFilter(const QString &filter);
+
+    QStringList types() const;
+    void setTypes(const QStringList &types);
+
+    bool ordered() const;
+    void setOrdered(bool ordered);
+
+    int maxConcurrency() const;
+    void setMaxConcurrency(int max_concurrency);
+
+    int pendingCount() const;
+
+    /// Set the number of actions in flight or waiting in the middleware. It is private API. Do not use it.
+    void setPendingCount(int pending_count);
+
+    /// Return true if filter or types is set.
+    bool hasTypes() const;
+
+    /// The atoms of filter and types.
+    QList<int> atoms() const;
+
+    /// Attach the middleware to a position of a chain. It is private API. Do not use it.
+    void setChain(QxMiddlewaresHook *hook, int index);
+
 public slots:
     void next(QString type, QJSValue message = QJSValue());
 
 private:
+    void updateAtoms();
+
     bool filter_function_enabled_;
+    QString filter_;
+    QStringList types_;
+    QList<int> atoms_;
+    bool ordered_;
+    int max_concurrency_;
+    int pending_count_;
     QJSValue next_callback_;
+    QPointer<QxMiddlewaresHook> hook_;
+    int index_;
 
 signals:
     void dispatched(QString type, QJSValue message);
     void filterFunctionEnabledChanged();
+    void filterChanged();
+    void typesChanged();
+    void orderedChanged();
+    void maxConcurrencyChanged();
+    void pendingCountChanged();
     void _nextCallbackChanged();
 
 };
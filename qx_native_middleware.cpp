@@ -0,0 +1,86 @@
+#include "qx_native_middleware.h"
+#include "private/qx_middlewares_hook.h"
+
+/*! \class QxNativeMiddleware
+    \brief Base class of middlewares written in C++
+
+    A QxNativeMiddleware subclass registered to QML could be placed in a QxMiddlewareList next to QxMiddleware.
+    The chain invokes it directly with the action, without calling into JavaScript.
+
+    \code
+    class Counter : public QxNativeMiddleware
+    {
+        Q_OBJECT
+        QML_ELEMENT
+    public:
+        void dispatch(const QxAction &action) override {
+            count_++;
+            next(action);
+        }
+    private:
+        int count_ = 0;
+    };
+    \endcode
+
+    An asynchronous middleware passes the future of its work to track(). The chain counts the action as
+    in flight until the future finishes, and applies ordered and maxConcurrency like QxMiddleware does.
+ */
+
+QxNativeMiddleware::QxNativeMiddleware(QQuickItem *parent)
+    : QQuickItem{parent}
+    , index_(-1)
+    , ordered_(true)
+    , max_concurrency_(0)
+{
+    // Intentionally left empty.
+}
+
+bool QxNativeMiddleware::ordered() const
+{
+    return ordered_;
+}
+
+void QxNativeMiddleware::setOrdered(bool ordered)
+{
+    if (ordered_ == ordered) {
+        return;
+    }
+
+    ordered_ = ordered;
+    emit orderedChanged();
+}
+
+int QxNativeMiddleware::maxConcurrency() const
+{
+    return max_concurrency_;
+}
+
+void QxNativeMiddleware::setMaxConcurrency(int max_concurrency)
+{
+    if (max_concurrency_ == max_concurrency) {
+        return;
+    }
+
+    max_concurrency_ = max_concurrency;
+    emit maxConcurrencyChanged();
+}
+
+void QxNativeMiddleware::setChain(QxMiddlewaresHook *hook, int index)
+{
+    hook_ = hook;
+    index_ = index;
+}
+
+void QxNativeMiddleware::next(const QxAction &action)
+{
+    if (!hook_.isNull()) {
+        hook_->next(index_, action);
+    }
+}
+
+void QxNativeMiddleware::track(const QFuture<void> &future)
+{
+    if (!hook_.isNull()) {
+        hook_->track(index_, future);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef QX_NATIVE_MIDDLEWARE_H
+#define QX_NATIVE_MIDDLEWARE_H
+
+#include <QFuture>
+#include <QPointer>
+#include <QQuickItem>
+
+#include "private/qx_action.h"
+
+class QxMiddlewaresHook;
+
+/// QxNativeMiddleware is the base of middlewares written in C++. Placed in a QxMiddlewareList,
+/// it receives actions as QxAction, so the message never crosses into JavaScript unless it asks for it.
+/// It is an item like QxMiddleware, so both keep their declaration order in the list.
+class QxNativeMiddleware : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(bool ordered READ ordered WRITE setOrdered NOTIFY orderedChanged)
+    Q_PROPERTY(int maxConcurrency READ maxConcurrency WRITE setMaxConcurrency NOTIFY maxConcurrencyChanged)
+    QML_ANONYMOUS
+public:
+    explicit QxNativeMiddleware(QQuickItem *parent = nullptr);
+
+    /// Process an action. Call next() to pass it on, otherwise it is dropped.
+    virtual void dispatch(const QxAction &action) = 0;
+
+    /// If true, one action is in flight at a time. Otherwise up to maxConcurrency, 0 for no limit. See QxMiddleware.
+    bool ordered() const;
+    void setOrdered(bool ordered);
+
+    int maxConcurrency() const;
+    void setMaxConcurrency(int max_concurrency);
+
+    /// Attach the middleware to a position of a chain. It is private API. Do not use it.
+    void setChain(QxMiddlewaresHook *hook, int index);
+
+protected:
+    /// Pass an action to the next middleware. If it is the last one, the action is delivered to the dispatcher.
+    void next(const QxAction &action);
+
+    /// Keep the action being dispatched in flight until future finishes. Call it from dispatch().
+    void track(const QFuture<void> &future);
+
+signals:
+    void orderedChanged();
+    void maxConcurrencyChanged();
+
+private:
+    QPointer<QxMiddlewaresHook> hook_;
+    int index_;
+    bool ordered_;
+    int max_concurrency_;
+};
+
+#endif // QX_NATIVE_MIDDLEWARE_H
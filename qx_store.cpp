@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <QtQml>
 
 #include "qx_store.h"
 #include "qx_app_dispatcher.h"
+#include "qx_filter.h"
 #include "private/quix_functions.h"
+#include "private/qx_atom_table.h"
 
 /*!
    \qmltype QxStore
@@ -58,6 +61,14 @@
     it will first re-dispatch the action to its children sequentially. Then emit the dispatched signal on itself.
     Therefore, the order of receivers is: page1, page2 then filter1.
 
+    A store skips the child stores which can't react to an action type, i.e. no filter, filter function
+    or receiver of the dispatched signal handles it in their tree. QxFilter children are invoked after
+    the receivers of the dispatched signal, and only if their type matches.
+
+    A store bound to a dispatcher receives an action after the QxAppListener components and native listeners,
+    and before the receivers of QxDispatcher::dispatched, e.g. a Connections element targeting the dispatcher.
+    They do not run in the order of connection.
+
     If the redispatchTargets property is set, Store component will also dispatch the received action to the listed objects.
 
  */
@@ -95,6 +106,8 @@
 
 /*! \qmlproperty bool QxStore::filterFunctionEnabled
     If this property is true, whatever the store component received a new action. Beside to emit a dispatched signal, it will search for a function with a name as the action. If it exists, it will call also call the function.
+    Only public and protected functions of a type derived from QxStore are filter functions.
+    Signals, such as property change notifiers, and the methods of QxStore itself are not.
 
     \code
         Store {
@@ -109,14 +122,27 @@
 
 QxStore::QxStore(QObject *parent)
     : QObject{parent}
+    , listener_(nullptr)
     , filter_function_enabled_(false)
+    , types_collected_(false)
+    , filter_index_(new QxFilterIndex(this))
 {
-    // Intentionally left empty.
+    connect(this, SIGNAL(filterFunctionEnabledChanged()), this, SLOT(invalidate()));
+    connect(filter_index_, SIGNAL(changed()), this, SLOT(invalidate()));
+}
+
+QxStore::~QxStore()
+{
+    if (!dispatcher_.isNull() && listener_) {
+        dispatcher_->removeListener(listener_->listenerId());
+    }
 }
 
 QQmlListProperty<QObject> QxStore::children()
 {
-    return QQmlListProperty<QObject>(qobject_cast<QObject *>(this), &children_);
+    return QQmlListProperty<QObject>(qobject_cast<QObject *>(this), &children_,
+                                     &QxStore::appendObject, &QxStore::objectCount,
+                                     &QxStore::objectAt, &QxStore::clearObjects);
 }
 
 /*! \qmlproperty object QxStore::bindSource
@@ -154,7 +180,14 @@ void QxStore::setBindSource(QObject *source)
 
 QQmlListProperty<QObject> QxStore::redispatchTargets()
 {
-    return QQmlListProperty<QObject>(qobject_cast<QObject *>(this), &redispatch_targets_);
+    return QQmlListProperty<QObject>(qobject_cast<QObject *>(this), &redispatch_targets_,
+                                     &QxStore::appendObject, &QxStore::objectCount,
+                                     &QxStore::objectAt, &QxStore::clearObjects);
+}
+
+QxFilterIndex *QxStore::filterIndex() const
+{
+    return filter_index_;
 }
 
 void QxStore::dispatch(QString type, QJSValue message)
@@ -162,45 +195,47 @@ void QxStore::dispatch(QString type, QJSValue message)
     QQmlEngine *engine = qmlEngine(this);
     QX_PRECHECK_DISPATCH(engine, type, message);
 
-    foreach(QObject *child , children_) {
-        QxStore *store = qobject_cast<QxStore *>(child);
-        if (!store) {
-            continue;
+    dispatch(QxAtomTable::intern(type), type, message);
+}
+
+void QxStore::dispatch(int atom, const QString &type, const QJSValue &message)
+{
+    // Hold a copy. Receivers may change the tree during the dispatch.
+    const Route route = this->route(atom);
+
+    for (const QPointer<QxStore> &store : route.targets) {
+        if (!store.isNull()) {
+            store->dispatch(atom, type, message);
         }
-        store->dispatch(type, message);
     }
 
-    foreach(QObject *child , redispatch_targets_) {
-        QxStore *store = qobject_cast<QxStore *>(child);
+    if (route.methods.with_message >= 0) {
+        QMetaMethod method = metaObject()->method(route.methods.with_message);
+        QVariant value = QVariant::fromValue<QJSValue>(message);
 
-        if (!store) {
-            continue;
-        }
-        store->dispatch(type, message);
+        method.invoke(this,Qt::DirectConnection, Q_ARG(QVariant, value));
     }
 
-    if (filter_function_enabled_) {
-        const QMetaObject *meta = metaObject();
-        QByteArray signature;
-        int index;
+    if (route.methods.without_message >= 0) {
+        QMetaMethod method = metaObject()->method(route.methods.without_message);
 
-        signature = QMetaObject::normalizedSignature(QString("%1(QVariant)").arg(type).toUtf8().constData());
-        if ( (index = meta->indexOfMethod(signature.constData())) >= 0 ) {
-            QMetaMethod method = meta->method(index);
-            QVariant value = QVariant::fromValue<QJSValue>(message);
+        method.invoke(this);
+    }
 
-            method.invoke(this,Qt::DirectConnection, Q_ARG(QVariant, value));
-        }
+    if (route.emit_signal) {
+        emit dispatched(type, message);
+    }
 
-        signature = QMetaObject::normalizedSignature(QString("%1()").arg(type).toUtf8().constData());
-        if ( (index = meta->indexOfMethod(signature.constData())) >= 0 ) {
-            QMetaMethod method = meta->method(index);
+    if (route.filtered) {
+        // A shared copy, so it does not allocate. The index detaches if a filter changes it.
+        const QList<QxFilter *> filters = filter_index_->filters(atom);
 
-            method.invoke(this);
+        for (QxFilter *filter : filters) {
+            if (filter_index_->contains(atom, filter)) {
+                filter->deliver(type, message);
+            }
         }
     }
-
-    emit dispatched(type, message);
 }
 
 void QxStore::bind(QObject *source)
@@ -234,7 +269,13 @@ void QxStore::setup()
 
     if (!dispatcher_.isNull() &&
         dispatcher_.data() != dispatcher) {
-        dispatcher_->disconnect(this);
+        dispatcher_->removeListener(listener_->listenerId());
+    }
+
+    if (listener_ && dispatcher_.data() != dispatcher) {
+        listener_->disconnect(this);
+        listener_->deleteLater();
+        listener_ = nullptr;
     }
 
     action_creator_ = creator;
@@ -245,8 +286,209 @@ void QxStore::setup()
                 this,SLOT(setup()));
     }
 
-    if (!dispatcher_.isNull()) {
-        connect(dispatcher,SIGNAL(dispatched(QString,QJSValue)),
-                this,SLOT(dispatch(QString,QJSValue)));
+    if (!dispatcher_.isNull() && !listener_) {
+        // Stores receive actions after the listeners and the native listeners, before the dispatched signal.
+        listener_ = new QxListener(this);
+        listener_->setTrailing(true);
+
+        // Declared before it is added, so it is indexed once.
+        updateTypes();
+
+        dispatcher_->addListener(listener_);
+
+        connect(listener_, SIGNAL(dispatched(int,QString,QJSValue)),
+                this, SLOT(onMessageReceived(int,QString,QJSValue)));
     }
 }
+
+void QxStore::onMessageReceived(int atom, const QString &type, const QJSValue &message)
+{
+    dispatch(atom, type, message);
+}
+
+void QxStore::updateTypes()
+{
+    if (!listener_) {
+        return;
+    }
+
+    QSet<int> types;
+
+    if (!collectTypes(types)) {
+        listener_->clearTypes();
+        return;
+    }
+
+    QList<int> atoms = types.values();
+    std::sort(atoms.begin(), atoms.end());
+    listener_->setTypes(atoms);
+}
+
+bool QxStore::collectTypes(QSet<int> &types)
+{
+    types_collected_ = true;
+
+    // A receiver of the signal, e.g. an onDispatched handler, may handle any type.
+    if (receivers(SIGNAL(dispatched(QString,QJSValue))) > 0) {
+        return false;
+    }
+
+    const QList<int> filtered = filter_index_->atoms();
+
+    for (int atom : filtered) {
+        types.insert(atom);
+    }
+
+    if (filter_function_enabled_) {
+        if (filter_functions_.isNull()) {
+            filter_functions_ = QxMethodTable::of(metaObject(), &QxStore::staticMetaObject, qmlEngine(this));
+        }
+
+        const QList<int> functions = filter_functions_->atoms();
+
+        for (int atom : functions) {
+            types.insert(atom);
+        }
+    }
+
+    return collectTypes(children_, types) && collectTypes(redispatch_targets_, types);
+}
+
+bool QxStore::collectTypes(const QObjectList &objects, QSet<int> &types)
+{
+    for (QObject *object : objects) {
+        QxStore *store = qobject_cast<QxStore *>(object);
+
+        if (!store) {
+            continue;
+        }
+
+        if (!store->upstream_.contains(this)) {
+            store->upstream_.append(this);
+        }
+
+        if (!store->collectTypes(types)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void QxStore::connectNotify(const QMetaMethod &signal)
+{
+    static const QMetaMethod dispatched_signal = QMetaMethod::fromSignal(&QxStore::dispatched);
+
+    if (signal == dispatched_signal) {
+        invalidate();
+    }
+}
+
+void QxStore::disconnectNotify(const QMetaMethod &signal)
+{
+    static const QMetaMethod dispatched_signal = QMetaMethod::fromSignal(&QxStore::dispatched);
+
+    if (signal == dispatched_signal) {
+        invalidate();
+    }
+}
+
+bool QxStore::Route::reacts() const
+{
+    return emit_signal ||
+           filtered ||
+           !targets.isEmpty() ||
+           methods.with_message >= 0 ||
+           methods.without_message >= 0;
+}
+
+const QxStore::Route &QxStore::route(int atom)
+{
+    auto iter = routes_.constFind(atom);
+
+    if (iter != routes_.constEnd()) {
+        return iter.value();
+    }
+
+    Route route;
+
+    appendTargets(children_, atom, route);
+    appendTargets(redispatch_targets_, atom, route);
+
+    if (filter_function_enabled_) {
+        if (filter_functions_.isNull()) {
+            filter_functions_ = QxMethodTable::of(metaObject(), &QxStore::staticMetaObject, qmlEngine(this));
+        }
+
+        route.methods = filter_functions_->methods(atom);
+    }
+
+    // A receiver of the signal, e.g. an onDispatched handler, may handle any type.
+    route.emit_signal = receivers(SIGNAL(dispatched(QString,QJSValue))) > 0;
+    route.filtered = filter_index_->contains(atom);
+
+    return routes_.insert(atom, route).value();
+}
+
+void QxStore::appendTargets(const QObjectList &objects, int atom, Route &route)
+{
+    for (QObject *object : objects) {
+        QxStore *store = qobject_cast<QxStore *>(object);
+
+        if (!store) {
+            continue;
+        }
+
+        if (!store->upstream_.contains(this)) {
+            store->upstream_.append(this);
+        }
+
+        if (store->route(atom).reacts()) {
+            route.targets.append(store);
+        }
+    }
+}
+
+void QxStore::invalidate()
+{
+    // Upstream routes and types are only computed along with those of this store.
+    // If there are none, the stores routing to it have nothing to drop either.
+    if (routes_.isEmpty() && !types_collected_) {
+        return;
+    }
+
+    routes_.clear();
+    types_collected_ = false;
+
+    const QList<QPointer<QxStore>> upstream = upstream_;
+
+    for (const QPointer<QxStore> &store : upstream) {
+        if (!store.isNull()) {
+            store->invalidate();
+        }
+    }
+
+    updateTypes();
+}
+
+void QxStore::appendObject(QQmlListProperty<QObject> *list, QObject *object)
+{
+    static_cast<QObjectList *>(list->data)->append(object);
+    static_cast<QxStore *>(list->object)->invalidate();
+}
+
+qsizetype QxStore::objectCount(QQmlListProperty<QObject> *list)
+{
+    return static_cast<QObjectList *>(list->data)->size();
+}
+
+QObject *QxStore::objectAt(QQmlListProperty<QObject> *list, qsizetype index)
+{
+    return static_cast<QObjectList *>(list->data)->at(index);
+}
+
+void QxStore::clearObjects(QQmlListProperty<QObject> *list)
+{
+    static_cast<QObjectList *>(list->data)->clear();
+    static_cast<QxStore *>(list->object)->invalidate();
+}
@@ -4,9 +4,12 @@
 #include <QObject>
 #include <QQmlEngine>
 #include <QQmlListProperty>
+#include <QSet>
 
 #include "qx_action_creator.h"
 #include "qx_dispatcher.h"
+#include "private/qx_filter_index.h"
+#include "private/qx_method_table.h"
 
 class QxStore : public QObject
 {
@@ -19,6 +22,7 @@ class QxStore : public QObject
     QML_ELEMENT
 public:
     explicit QxStore(QObject *parent = nullptr);
+    ~QxStore();
 
     QQmlListProperty<QObject> children();
 
@@ -27,6 +31,9 @@ public:
 
     QQmlListProperty<QObject> redispatchTargets();
 
+    /// The QxFilter children of this store. It is private API. Do not use it.
+    QxFilterIndex *filterIndex() const;
+
 public slots:
     void dispatch(QString type, QJSValue message = QJSValue());
 
@@ -36,7 +43,44 @@ protected:
     void classBegin();
     void componentComplete();
 
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
 private:
+    // How a store handles an action type
+    struct Route
+    {
+        // Stores which react to the type, in the order of delivery
+        QList<QPointer<QxStore>> targets;
+
+        QxMethodTable::Methods methods;
+
+        // True if a receiver of the dispatched signal may handle the type
+        bool emit_signal = false;
+
+        // True if a QxFilter child matches the type
+        bool filtered = false;
+
+        bool reacts() const;
+    };
+
+    void dispatch(int atom, const QString &type, const QJSValue &message);
+
+    // Obtain the route of atom. Routes are computed on demand, and dropped by invalidate().
+    const Route &route(int atom);
+
+    void appendTargets(const QObjectList &objects, int atom, Route &route);
+
+    // Add the types this store and the stores it routes to may react to. Returns false if it may react to any type.
+    bool collectTypes(QSet<int> &types);
+
+    bool collectTypes(const QObjectList &objects, QSet<int> &types);
+
+    static void appendObject(QQmlListProperty<QObject> *list, QObject *object);
+    static qsizetype objectCount(QQmlListProperty<QObject> *list);
+    static QObject *objectAt(QQmlListProperty<QObject> *list, qsizetype index);
+    static void clearObjects(QQmlListProperty<QObject> *list);
+
     QObjectList children_;
 
     QPointer<QObject> bind_source_;
@@ -45,13 +89,38 @@ private:
 
     QPointer<QxDispatcher> dispatcher_;
 
+    // Receives the actions of the dispatcher. It declares the types of this store, so other actions are not
+    // materialized for it.
+    QxListener *listener_;
+
     QObjectList redispatch_targets_;
 
     bool filter_function_enabled_;
 
+    // Filter functions by type. It is obtained on the first dispatch with filterFunctionEnabled.
+    QSharedPointer<const QxMethodTable> filter_functions_;
+
+    QHash<int, Route> routes_;
+
+    // True if the types of this store were collected since the last invalidate().
+    bool types_collected_;
+
+    QxFilterIndex *filter_index_;
+
+    // Stores which route actions to this store. Their routes depend on this one.
+    QList<QPointer<QxStore>> upstream_;
+
 private slots:
     void setup();
 
+    void onMessageReceived(int atom, const QString &type, const QJSValue &message);
+
+    // Report the types this store may react to, if it is bound to a dispatcher.
+    void updateTypes();
+
+    // Drop the routes of this store and of the stores routing to it.
+    void invalidate();
+
 signals:
     void dispatched(QString type, QJSValue message);
 
@@ -0,0 +1,175 @@
+#include <QtDebug>
+
+#include "qx_throttle.h"
+#include "private/qx_timer_service.h"
+
+/*!
+    \qmltype QxThrottle
+    \inqmlmodule QuixFlux
+    \brief A native middleware passing at most one action per interval
+
+    \code
+        import QuixFlux
+    \endcode
+
+    QxThrottle is placed in a QxMiddlewareList. For each type in types, and each value at keyPath,
+    it passes the first action (if leading is true) and suppresses the others for interval msecs.
+    If trailing is true, the latest suppressed action is passed when the interval has elapsed.
+
+    Suppressed actions are dropped in C++, so they never reach JavaScript.
+    The timers of all instances are served by a single timer.
+
+    \code
+        QxMiddlewareList {
+            applyTarget: QxAppDispatcher
+
+            QxThrottle {
+                types: [ActionTypes.scroll]
+                interval: 50
+            }
+        }
+    \endcode
+ */
+
+/*! \qmlproperty array QxThrottle::types
+    The types it applies to. If it is empty, every action is throttled.
+ */
+
+/*! \qmlproperty string QxThrottle::keyPath
+    A dot separated path into the message. Actions with different values at the path are throttled independently.
+ */
+
+/*! \qmlproperty int QxThrottle::interval
+    The length of the window in msecs. The default value is 100.
+ */
+
+QxThrottle::QxThrottle(QQuickItem *parent)
+    : QxKeyedMiddleware{parent}
+    , leading_(true)
+    , trailing_(true)
+    , edges_warned_(false)
+{
+    // Intentionally left empty.
+}
+
+QxThrottle::~QxThrottle()
+{
+    for (const Window &window : std::as_const(windows_)) {
+        QxTimerService::instance()->stop(window.timer);
+    }
+}
+
+/*! \qmlproperty bool QxThrottle::leading
+    If it is true, the action opening a window is passed immediately. The default value is true.
+ */
+
+bool QxThrottle::leading() const
+{
+    return leading_;
+}
+
+void QxThrottle::setLeading(bool leading)
+{
+    if (leading_ == leading) {
+        return;
+    }
+
+    leading_ = leading;
+    emit leadingChanged();
+}
+
+/*! \qmlproperty bool QxThrottle::trailing
+    If it is true, the latest action suppressed in a window is passed when it is closed. The default value is true.
+    If both leading and trailing are false, actions are passed on untouched with a warning.
+ */
+
+bool QxThrottle::trailing() const
+{
+    return trailing_;
+}
+
+void QxThrottle::setTrailing(bool trailing)
+{
+    if (trailing_ == trailing) {
+        return;
+    }
+
+    trailing_ = trailing;
+    emit trailingChanged();
+}
+
+void QxThrottle::dispatch(const QxAction &action)
+{
+    if (!accepts(action)) {
+        next(action);
+        return;
+    }
+
+    if (!leading_ && !trailing_) {
+        // Nothing would ever be passed. The action is passed on untouched instead.
+        if (!edges_warned_) {
+            qWarning() << "QxThrottle: Neither leading nor trailing is enabled. Actions are not throttled.";
+            edges_warned_ = true;
+        }
+        next(action);
+        return;
+    }
+
+    Key key;
+
+    if (!keyOf(action, &key)) {
+        next(action);
+        return;
+    }
+
+    auto iter = windows_.find(key);
+
+    if (iter != windows_.end()) {
+        if (trailing_) {
+            iter->trailing = action;
+        }
+        return;
+    }
+
+    Window window;
+    window.timer = startWindow(key);
+
+    if (!leading_ && trailing_) {
+        window.trailing = action;
+    }
+
+    windows_.insert(key, window);
+
+    if (leading_) {
+        next(action);
+    }
+}
+
+int QxThrottle::startWindow(const Key &key)
+{
+    return QxTimerService::instance()->start(interval(), this, [this, key]() {
+        onWindowElapsed(key);
+    });
+}
+
+void QxThrottle::onWindowElapsed(const Key &key)
+{
+    auto iter = windows_.find(key);
+
+    if (iter == windows_.end()) {
+        return;
+    }
+
+    const QxAction action = iter->trailing;
+
+    if (action.isNull()) {
+        windows_.erase(iter);
+        return;
+    }
+
+    // The trailing action opens the next window, so the rate holds across windows.
+    iter->trailing = QxAction();
+    iter->timer = startWindow(key);
+
+    next(action);
+}
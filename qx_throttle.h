@@ -0,0 +1,51 @@
+#ifndef QX_THROTTLE_H
+#define QX_THROTTLE_H
+
+#include <QHash>
+
+#include "qx_keyed_middleware.h"
+
+class QxThrottle : public QxKeyedMiddleware
+{
+    Q_OBJECT
+    Q_PROPERTY(bool leading READ leading WRITE setLeading NOTIFY leadingChanged)
+    Q_PROPERTY(bool trailing READ trailing WRITE setTrailing NOTIFY trailingChanged)
+    QML_ELEMENT
+public:
+    explicit QxThrottle(QQuickItem *parent = nullptr);
+    ~QxThrottle();
+
+    bool leading() const;
+    void setLeading(bool leading);
+
+    bool trailing() const;
+    void setTrailing(bool trailing);
+
+    void dispatch(const QxAction &action) override;
+
+signals:
+    void leadingChanged();
+    void trailingChanged();
+
+private:
+    // A window of interval msecs started by an action. Later actions of the window are suppressed,
+    // and the latest one is kept for the trailing edge.
+    struct Window
+    {
+        int timer = 0;
+        QxAction trailing;
+    };
+
+    int startWindow(const Key &key);
+
+    void onWindowElapsed(const Key &key);
+
+    bool leading_;
+    bool trailing_;
+
+    // True once a dispatch has warned that neither edge is enabled.
+    bool edges_warned_;
+    QHash<Key, Window> windows_;
+};
+
+#endif // QX_THROTTLE_H
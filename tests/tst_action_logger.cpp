@@ -0,0 +1,54 @@
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QTemporaryDir>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QtTest>
+
+#include "qx_action_logger.h"
+#include "qx_app_dispatcher.h"
+
+Q_IMPORT_QML_PLUGIN(QuixFluxPlugin)
+
+class TestActionLogger : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void droppedCount();
+};
+
+void TestActionLogger::droppedCount()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString file_name = dir.filePath("actions.qxlog");
+
+    QQmlEngine engine;
+    QQmlComponent comp(&engine);
+    comp.setData(QString("import QuixFlux\nQxActionLogger { bufferSize: 4096; fileName: \"%1\" }").arg(file_name).toUtf8(), QUrl());
+
+    QScopedPointer<QObject> object(comp.create());
+    QxActionLogger *logger = qobject_cast<QxActionLogger *>(object.data());
+    QVERIFY2(logger, qPrintable(comp.errorString()));
+
+    QxAppDispatcher *dispatcher = QxAppDispatcher::instance(&engine);
+    QVERIFY(dispatcher);
+
+    // A record larger than the buffer never fits. It is dropped instead of blocking the dispatcher.
+    dispatcher->dispatch("large", QVariant(QString(8192, QLatin1Char('x'))));
+    QTRY_COMPARE(logger->droppedCount(), 1);
+
+    dispatcher->dispatch("small", QVariant(QString("x")));
+    QCOMPARE(logger->droppedCount(), 1);
+
+    // The writer thread is stopped and the file closed.
+    object.reset();
+
+    QFile file(file_name);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.read(4) == "QXLG");
+}
+
+QTEST_MAIN(TestActionLogger)
+
+#include "tst_action_logger.moc"
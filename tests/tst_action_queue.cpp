@@ -0,0 +1,254 @@
+#include <QQmlEngine>
+#include <QtTest>
+
+#include "qx_action_queue.h"
+#include "qx_atom_table.h"
+
+// Lets a merge function enqueue into the queue it is called from.
+class QueueHandle : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QueueHandle(QxActionQueue *queue)
+        : queue_(queue)
+    {
+    }
+
+    Q_INVOKABLE void enqueue(const QString &type, const QJSValue &message)
+    {
+        queue_->enqueue(QxAction(QxAtomTable::intern(type), message));
+    }
+
+private:
+    QxActionQueue *queue_;
+};
+
+class TestActionQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keepAllKeepsOrder();
+    void latestWinsReplacesInPlace();
+    void mergeKeepsPosition();
+    void mergeReentersQueue();
+    void highLaneGoesFirst();
+    void expiredActionsAreDropped();
+    void appendBypassesLanesAndPolicy();
+    void pendingSurvivesCompaction();
+
+private:
+    // Dequeue everything as "type=value" strings.
+    QStringList drain(QxActionQueue &queue, QQmlEngine *engine = nullptr);
+};
+
+QStringList TestActionQueue::drain(QxActionQueue &queue, QQmlEngine *engine)
+{
+    QStringList result;
+    QxAction action;
+
+    while (queue.dequeue(&action)) {
+        const QString value = action.isNative() ? action.payload().toString() : action.message(engine).toString();
+        result << QString("%1=%2").arg(action.type(), value);
+    }
+
+    return result;
+}
+
+void TestActionQueue::keepAllKeepsOrder()
+{
+    QxActionQueue queue;
+    const int a = QxAtomTable::intern("a");
+    const int b = QxAtomTable::intern("b");
+
+    queue.enqueue(QxAction(a, 1));
+    queue.enqueue(QxAction(b, 2));
+    queue.enqueue(QxAction(a, 3));
+    QCOMPARE(queue.size(), 3);
+
+    QCOMPARE(drain(queue), QStringList() << "a=1" << "b=2" << "a=3");
+    QVERIFY(queue.isEmpty());
+}
+
+void TestActionQueue::latestWinsReplacesInPlace()
+{
+    QxActionQueue queue;
+    const int a = QxAtomTable::intern("a");
+    const int b = QxAtomTable::intern("b");
+    queue.setPolicy(a, QxActionQueue::LatestWins);
+
+    queue.enqueue(QxAction(a, 1));
+    queue.enqueue(QxAction(b, 2));
+    queue.enqueue(QxAction(a, 3));
+    QCOMPARE(queue.size(), 2);
+
+    QxAction action;
+    QVERIFY(queue.dequeue(&action));
+    QCOMPARE(action.type(), QString("a"));
+    QCOMPARE(action.payload().toInt(), 3);
+
+    // The pending action is delivered, so the next one is queued behind b.
+    queue.enqueue(QxAction(a, 4));
+    QCOMPARE(drain(queue), QStringList() << "b=2" << "a=4");
+}
+
+void TestActionQueue::mergeKeepsPosition()
+{
+    QQmlEngine engine;
+    QxActionQueue queue;
+    queue.setEngine(&engine);
+    const int a = QxAtomTable::intern("a");
+    const int b = QxAtomTable::intern("b");
+    queue.setPolicy(a, QxActionQueue::Merge, engine.evaluate("(function(previous, next) { return previous + next; })"));
+
+    queue.enqueue(QxAction(a, 1));
+    queue.enqueue(QxAction(b, 2));
+    queue.enqueue(QxAction(a, 3));
+    queue.enqueue(QxAction(a, 5));
+
+    QCOMPARE(drain(queue, &engine), QStringList() << "a=9" << "b=2");
+}
+
+void TestActionQueue::mergeReentersQueue()
+{
+    QQmlEngine engine;
+    QxActionQueue queue;
+    queue.setEngine(&engine);
+    QueueHandle handle(&queue);
+    const int a = QxAtomTable::intern("a");
+
+    // The merge function enqueues enough actions to reallocate the lane it is merging into.
+    QJSValue factory = engine.evaluate(
+        "(function(handle) {"
+        "    return function(previous, next) {"
+        "        for (var i = 0 ; i < 100 ; i++) {"
+        "            handle.enqueue('filler', i);"
+        "        }"
+        "        return previous + next;"
+        "    };"
+        "})");
+    QQmlEngine::setObjectOwnership(&handle, QQmlEngine::CppOwnership);
+    QJSValue merge = factory.call(QJSValueList() << engine.newQObject(&handle));
+    queue.setPolicy(a, QxActionQueue::Merge, merge);
+
+    queue.enqueue(QxAction(a, 1));
+    queue.enqueue(QxAction(a, 2));
+    QCOMPARE(queue.size(), 101);
+
+    const QStringList delivered = drain(queue, &engine);
+    QCOMPARE(delivered.size(), 101);
+    QCOMPARE(delivered.first(), QString("a=3"));
+    QCOMPARE(delivered.at(1), QString("filler=0"));
+    QCOMPARE(delivered.last(), QString("filler=99"));
+}
+
+void TestActionQueue::highLaneGoesFirst()
+{
+    QxActionQueue queue;
+    const int low = QxAtomTable::intern("low");
+    const int normal = QxAtomTable::intern("normal");
+    const int high = QxAtomTable::intern("high");
+    queue.setLane(low, QxActionQueue::LowLane);
+    queue.setLane(high, QxActionQueue::HighLane);
+    QCOMPARE(queue.lane(normal), int(QxActionQueue::NormalLane));
+
+    queue.enqueue(QxAction(low, 1));
+    queue.enqueue(QxAction(normal, 2));
+    queue.enqueue(QxAction(high, 3));
+    queue.enqueue(QxAction(normal, 4));
+    queue.enqueue(QxAction(high, 5));
+
+    QCOMPARE(queue.size(QxActionQueue::HighLane), 2);
+    QCOMPARE(queue.size(QxActionQueue::NormalLane), 2);
+    QCOMPARE(queue.size(QxActionQueue::LowLane), 1);
+
+    QCOMPARE(drain(queue), QStringList() << "high=3" << "high=5" << "normal=2" << "normal=4" << "low=1");
+}
+
+void TestActionQueue::expiredActionsAreDropped()
+{
+    QxActionQueue queue;
+    const int a = QxAtomTable::intern("a");
+    const int b = QxAtomTable::intern("b");
+    const QDeadlineTimer expired(0);
+    const QDeadlineTimer forever(QDeadlineTimer::Forever);
+
+    queue.enqueue(QxAction(a, 1), QxActionQueue::NormalLane, expired);
+    queue.enqueue(QxAction(b, 2), QxActionQueue::NormalLane, forever);
+    queue.enqueue(QxAction(a, 3), QxActionQueue::LowLane, expired);
+
+    QCOMPARE(drain(queue), QStringList() << "b=2");
+    QCOMPARE(queue.expiredCount(), 2);
+
+    // A coalesced action takes the deadline of the latest one.
+    queue.setPolicy(a, QxActionQueue::LatestWins);
+    queue.enqueue(QxAction(a, 4), QxActionQueue::NormalLane, expired);
+    queue.enqueue(QxAction(a, 5), QxActionQueue::NormalLane, forever);
+
+    QCOMPARE(drain(queue), QStringList() << "a=5");
+    QCOMPARE(queue.expiredCount(), 2);
+}
+
+void TestActionQueue::appendBypassesLanesAndPolicy()
+{
+    QxActionQueue queue;
+    const int a = QxAtomTable::intern("a");
+    queue.setLane(a, QxActionQueue::HighLane);
+    queue.setPolicy(a, QxActionQueue::LatestWins);
+
+    queue.append(QxAction(a, 1));
+    queue.append(QxAction(a, 2));
+    QCOMPARE(queue.size(QxActionQueue::NormalLane), 2);
+    QCOMPARE(queue.size(QxActionQueue::HighLane), 0);
+
+    // An appended action is never the pending one of its type.
+    queue.enqueue(QxAction(a, 3));
+    queue.enqueue(QxAction(a, 4));
+    QCOMPARE(queue.size(QxActionQueue::HighLane), 1);
+
+    QxAction action;
+    QVERIFY(queue.dequeue(&action));
+    QCOMPARE(action.payload().toInt(), 4);
+
+    // Delivering an appended action of the same lane leaves the pending one alone.
+    queue.setLane(a, QxActionQueue::NormalLane);
+    queue.enqueue(QxAction(a, 5));
+    QVERIFY(queue.dequeue(&action));
+    QCOMPARE(action.payload().toInt(), 1);
+
+    queue.enqueue(QxAction(a, 6));
+    QCOMPARE(drain(queue), QStringList() << "a=2" << "a=6");
+}
+
+void TestActionQueue::pendingSurvivesCompaction()
+{
+    QxActionQueue queue;
+    const int a = QxAtomTable::intern("a");
+    const int filler = QxAtomTable::intern("filler");
+    queue.setPolicy(a, QxActionQueue::LatestWins);
+
+    for (int i = 0 ; i < 3000 ; i++) {
+        queue.enqueue(QxAction(filler, i));
+    }
+    queue.enqueue(QxAction(a, 1));
+
+    // Delivering past the compaction threshold moves the pending action within the lane.
+    QxAction action;
+    for (int i = 0 ; i < 2000 ; i++) {
+        QVERIFY(queue.dequeue(&action));
+        QCOMPARE(action.payload().toInt(), i);
+    }
+
+    queue.enqueue(QxAction(a, 2));
+    QCOMPARE(queue.size(), 1001);
+
+    const QStringList delivered = drain(queue);
+    QCOMPARE(delivered.size(), 1001);
+    QCOMPARE(delivered.at(999), QString("filler=2999"));
+    QCOMPARE(delivered.last(), QString("a=2"));
+}
+
+QTEST_MAIN(TestActionQueue)
+
+#include "tst_action_queue.moc"
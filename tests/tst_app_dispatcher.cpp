@@ -0,0 +1,80 @@
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QtQml/qqmlextensionplugin.h>
+#include <QtTest>
+
+#include "qx_app_dispatcher.h"
+#include "qx_engine_registry.h"
+
+Q_IMPORT_QML_PLUGIN(QuixFluxPlugin)
+
+// The lookup QxAppDispatcher::instance() used before QxEngineRegistry: a component is compiled per call.
+static QObject *instanceByComponent(QQmlEngine *engine)
+{
+    QQmlComponent comp(engine);
+    comp.setData("import QtQuick\nimport QuixFlux 1.0;QtObject { property var object : QxAppDispatcher }", QUrl());
+
+    QScopedPointer<QObject> holder(comp.create());
+
+    if (!holder) {
+        return nullptr;
+    }
+
+    return holder->property("object").value<QObject *>();
+}
+
+class TestAppDispatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void instance();
+    void instanceIsDroppedWithEngine();
+    void benchmarkInstanceByComponent();
+    void benchmarkInstanceByRegistry();
+};
+
+void TestAppDispatcher::instance()
+{
+    QQmlEngine engine;
+
+    QxAppDispatcher *dispatcher = QxAppDispatcher::instance(&engine);
+    QVERIFY(dispatcher);
+    QCOMPARE(QxAppDispatcher::instance(&engine), dispatcher);
+    QCOMPARE(instanceByComponent(&engine), dispatcher);
+}
+
+void TestAppDispatcher::instanceIsDroppedWithEngine()
+{
+    QScopedPointer<QQmlEngine> engine(new QQmlEngine);
+    QVERIFY(QxAppDispatcher::instance(engine.data()));
+
+    QQmlEngine *key = engine.data();
+    engine.reset();
+
+    QVERIFY(!QxEngineRegistry::object(key, QxEngineRegistry::key("QuixFlux", 1, "QxAppDispatcher")));
+}
+
+void TestAppDispatcher::benchmarkInstanceByComponent()
+{
+    QQmlEngine engine;
+    QVERIFY(instanceByComponent(&engine));
+
+    QBENCHMARK {
+        instanceByComponent(&engine);
+    }
+}
+
+void TestAppDispatcher::benchmarkInstanceByRegistry()
+{
+    QQmlEngine engine;
+    QVERIFY(QxAppDispatcher::instance(&engine));
+
+    QBENCHMARK {
+        QxAppDispatcher::instance(&engine);
+    }
+}
+
+QTEST_MAIN(TestAppDispatcher)
+
+#include "tst_app_dispatcher.moc"
@@ -0,0 +1,96 @@
+#include <QtTest>
+
+#include "qx_app_script_runnable.h"
+
+class TestAppScriptRunnablePool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reuse();
+    void freeChain();
+    void exhaustedSlotIsRetired();
+    void full();
+};
+
+void TestAppScriptRunnablePool::reuse()
+{
+    QxAppScriptRunnablePool pool;
+
+    const int first = pool.create();
+    QVERIFY(pool.at(first));
+
+    pool.free(first);
+    QVERIFY(!pool.at(first));
+
+    // The slot is reused with another generation, so the freed id does not resolve to its successor.
+    const int second = pool.create();
+    QCOMPARE(second & 0xffff, first & 0xffff);
+    QVERIFY(second != first);
+    QVERIFY(pool.at(second));
+    QVERIFY(!pool.at(first));
+}
+
+void TestAppScriptRunnablePool::freeChain()
+{
+    QxAppScriptRunnablePool pool;
+
+    const int first = pool.create();
+    const int second = pool.create();
+    const int other = pool.create();
+    pool.at(first)->next = second;
+
+    pool.free(first);
+    QVERIFY(!pool.at(first));
+    QVERIFY(!pool.at(second));
+    QVERIFY(pool.at(other));
+
+    pool.clear();
+    QVERIFY(!pool.at(other));
+}
+
+void TestAppScriptRunnablePool::exhaustedSlotIsRetired()
+{
+    QxAppScriptRunnablePool pool;
+
+    const int first = pool.create();
+    int id = first;
+
+    for (int i = 0 ; i < 0x7fff ; i++) {
+        pool.free(id);
+        id = pool.create();
+        QVERIFY(id >= 0);
+        QVERIFY(id != first);
+        QCOMPARE(id & 0xffff, first & 0xffff);
+    }
+
+    // The last generation of the slot is used. Once freed, the slot is never handed out again.
+    pool.free(id);
+
+    for (int i = 0 ; i < 4 ; i++) {
+        const int next = pool.create();
+        QVERIFY(next >= 0);
+        QVERIFY((next & 0xffff) != (first & 0xffff));
+        QVERIFY(!pool.at(first));
+    }
+}
+
+void TestAppScriptRunnablePool::full()
+{
+    QxAppScriptRunnablePool pool;
+
+    for (int i = 0 ; i < 0x10000 ; i++) {
+        QCOMPARE(pool.create(), i);
+    }
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Too many callbacks"));
+    QCOMPARE(pool.create(), -1);
+
+    // A freed slot may be used again.
+    pool.free(0);
+    QVERIFY(pool.create() >= 0);
+}
+
+QTEST_MAIN(TestAppScriptRunnablePool)
+
+#include "tst_app_script_runnable_pool.moc"
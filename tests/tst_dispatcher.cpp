@@ -0,0 +1,466 @@
+#include <QQmlEngine>
+#include <QtTest>
+
+#include "qx_action_creator.h"
+#include "qx_dispatcher.h"
+#include "qx_listener.h"
+#include "qx_listener_registry.h"
+#include "qx_store.h"
+
+// A store with a filter function, as a QML type derived from QxStore would declare it.
+class ItemStore : public QxStore
+{
+    Q_OBJECT
+public:
+    QVariantList added;
+
+public slots:
+    void addItem(const QVariant &message)
+    {
+        added << message;
+    }
+};
+
+// A receiver of typed native listeners.
+class ItemModel : public QObject
+{
+    Q_OBJECT
+public:
+    QList<QVariantMap> items;
+
+    void onItemAdded(const QVariantMap &item)
+    {
+        items << item;
+    }
+};
+
+// A signal argument which QVariant can't convert to a message by itself.
+struct Money
+{
+    int amount;
+    QString currency;
+};
+
+Q_DECLARE_METATYPE(Money)
+
+class PaymentCreator : public QxActionCreator
+{
+    Q_OBJECT
+signals:
+    void paid(const Money &money);
+};
+
+class TestDispatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void registryReusesSlots();
+    void registryRetiresExhaustedSlots();
+    void waitForOrdersDelivery();
+    void cyclicWaitForIsRejected();
+    void storeDeclaresTypes();
+    void storeInternalsAreNotFilterFunctions();
+    void storeRunsBeforeDispatchedSignal();
+    void batchDeliversRunsInOrder();
+    void nativeListenersKeepRegistrationOrder();
+    void typedNativeListenerConverts();
+    void nativeListenerRemovedDuringDelivery();
+    void converterWithoutScriptListeners();
+    void benchmarkDispatchLoop();
+    void benchmarkDispatchBatch();
+
+private:
+    // A batch of count actions of one type, and a dispatcher with listeners of that type.
+    QList<QPair<QString, QVariant>> prepareBurst(QxDispatcher *dispatcher, int count, int *received);
+
+    QxListener *addListener(QxDispatcher *dispatcher, const QString &name, QStringList *log);
+};
+
+QxListener *TestDispatcher::addListener(QxDispatcher *dispatcher, const QString &name, QStringList *log)
+{
+    QxListener *listener = new QxListener(dispatcher);
+
+    connect(listener, &QxListener::dispatched, this, [name, log]() {
+        *log << name;
+    });
+
+    dispatcher->addListener(listener);
+
+    return listener;
+}
+
+void TestDispatcher::registryReusesSlots()
+{
+    QxListenerRegistry registry;
+    QxListener a, b;
+
+    const int slot = registry.insert(&a);
+    const int id = registry.id(slot);
+    QCOMPARE(registry.find(id), slot);
+
+    registry.remove(slot);
+    QCOMPARE(registry.find(id), -1);
+
+    // The slot is reused, but the id of the removed listener does not resolve to b.
+    const int reused = registry.insert(&b);
+    QCOMPARE(reused, slot);
+    QVERIFY(registry.id(reused) != id);
+    QCOMPARE(registry.find(id), -1);
+    QVERIFY(registry.order(reused) > 0);
+}
+
+void TestDispatcher::registryRetiresExhaustedSlots()
+{
+    QxListenerRegistry registry;
+    QxListener listener;
+
+    const int slot = registry.insert(&listener);
+    const int first_id = registry.id(slot);
+    registry.remove(slot);
+
+    QSet<int> ids;
+    ids.insert(first_id);
+
+    // Each reuse yields a new id, until the generation is exhausted.
+    for (;;) {
+        const int reused = registry.insert(&listener);
+
+        if (reused != slot) {
+            QCOMPARE(reused, slot + 1);
+            break;
+        }
+
+        const int id = registry.id(reused);
+        QVERIFY(!ids.contains(id));
+        ids.insert(id);
+        registry.remove(reused);
+    }
+
+    QCOMPARE(ids.size(), 2048);
+    QCOMPARE(registry.find(first_id), -1);
+}
+
+void TestDispatcher::waitForOrdersDelivery()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    QxListener *b = addListener(&dispatcher, "b", &log);
+    QxListener *a = addListener(&dispatcher, "a", &log);
+
+    dispatcher.dispatch("test", QVariant());
+    QCOMPARE(log, QStringList() << "b" << "a");
+
+    QVERIFY(b->setWaitFor(QList<int>() << a->listenerId()));
+
+    log.clear();
+    dispatcher.dispatch("test", QVariant());
+    QCOMPARE(log, QStringList() << "a" << "b");
+}
+
+void TestDispatcher::cyclicWaitForIsRejected()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    QxListener *a = addListener(&dispatcher, "a", &log);
+    QxListener *b = addListener(&dispatcher, "b", &log);
+    QxListener *c = addListener(&dispatcher, "c", &log);
+
+    QVERIFY(a->setWaitFor(QList<int>() << b->listenerId()));
+    QVERIFY(b->setWaitFor(QList<int>() << c->listenerId()));
+
+    // c -> a -> b -> c
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Cyclic dependency detected"));
+    QVERIFY(!c->setWaitFor(QList<int>() << a->listenerId()));
+    QCOMPARE(c->waitFor(), QList<int>());
+
+    // The plan is kept.
+    dispatcher.dispatch("test", QVariant());
+    QCOMPARE(log, QStringList() << "c" << "b" << "a");
+
+    // Removing a listener breaks the cycle.
+    dispatcher.removeListener(a->listenerId());
+    QVERIFY(c->setWaitFor(QList<int>() << a->listenerId()));
+}
+
+void TestDispatcher::storeDeclaresTypes()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QxStore store;
+    QStringList log;
+
+    store.setBindSource(&dispatcher);
+
+    // The store has nothing to react with, so a native message would not be converted for it.
+    const int atom = dispatcher.typeAtom("test");
+    QVERIFY(!dispatcher.hasScriptListeners(atom));
+
+    connect(&store, &QxStore::dispatched, this, [&log]() {
+        log << "store";
+    });
+    QVERIFY(dispatcher.hasScriptListeners(atom));
+
+    // A store receives actions after the listeners, even those added later.
+    addListener(&dispatcher, "listener", &log);
+
+    dispatcher.dispatch("test", QVariant());
+    QCOMPARE(log, QStringList() << "listener" << "store");
+}
+
+void TestDispatcher::storeInternalsAreNotFilterFunctions()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    ItemStore store;
+
+    store.setProperty("filterFunctionEnabled", true);
+    store.setBindSource(&dispatcher);
+
+    // Only the functions of the derived type are declared.
+    QVERIFY(dispatcher.hasScriptListeners(dispatcher.typeAtom("addItem")));
+    QVERIFY(!dispatcher.hasScriptListeners(dispatcher.typeAtom("invalidate")));
+    QVERIFY(!dispatcher.hasScriptListeners(dispatcher.typeAtom("updateTypes")));
+    QVERIFY(!dispatcher.hasScriptListeners(dispatcher.typeAtom("setup")));
+
+    // An action named after a private slot of QxStore does not reach it. The routes stay in place.
+    dispatcher.dispatch("invalidate", QVariant());
+    dispatcher.dispatch("addItem", QVariant(1));
+    QCOMPARE(store.added.size(), 1);
+}
+
+void TestDispatcher::storeRunsBeforeDispatchedSignal()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    // Connected before the store is bound. It still receives the action after the store.
+    connect(&dispatcher, &QxDispatcher::dispatched, this, [&log]() {
+        log << "signal";
+    });
+
+    QxStore store;
+    connect(&store, &QxStore::dispatched, this, [&log]() {
+        log << "store";
+    });
+    store.setBindSource(&dispatcher);
+
+    dispatcher.dispatch("test", QVariant());
+    QCOMPARE(log, QStringList() << "store" << "signal");
+}
+
+void TestDispatcher::batchDeliversRunsInOrder()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    QxListener *listener = new QxListener(&dispatcher);
+    listener->setTypes(QList<int>() << dispatcher.typeAtom("a") << dispatcher.typeAtom("b"));
+    dispatcher.addListener(listener);
+
+    connect(listener, &QxListener::dispatched, this, [&](int, const QString &type, const QJSValue &) {
+        log << type;
+        dispatcher.defer(this, [&log, type]() {
+            log << "deferred " + type;
+        });
+    });
+
+    dispatcher.dispatchBatch(QList<QPair<QString, QVariant>>()
+                             << qMakePair(QString("a"), QVariant(1))
+                             << qMakePair(QString("a"), QVariant(2))
+                             << qMakePair(QString("b"), QVariant(3))
+                             << qMakePair(QString("c"), QVariant(4)));
+
+    // Deferred callbacks run between the actions of a run.
+    QCOMPARE(log, QStringList() << "a" << "deferred a" << "a" << "deferred a" << "b" << "deferred b");
+}
+
+void TestDispatcher::nativeListenersKeepRegistrationOrder()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    dispatcher.addNativeListener(QStringList(), [&log](const QString &type, const QVariant &) {
+        log << "any " + type;
+    });
+    dispatcher.addNativeListener(QStringList() << "a", [&log](const QString &type, const QVariant &) {
+        log << "typed " + type;
+    });
+    dispatcher.addNativeListener(QStringList(), [&log](const QString &type, const QVariant &) {
+        log << "last " + type;
+    });
+
+    // Typed and untyped listeners are merged in the order they were added.
+    dispatcher.dispatch("a", QVariant());
+    dispatcher.dispatch("b", QVariant());
+    QCOMPARE(log, QStringList() << "any a" << "typed a" << "last a" << "any b" << "last b");
+
+    // Native listeners do not need the message in JavaScript.
+    QVERIFY(!dispatcher.hasScriptListeners(dispatcher.typeAtom("a")));
+}
+
+void TestDispatcher::typedNativeListenerConverts()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    ItemModel *model = new ItemModel;
+
+    dispatcher.addNativeListener<QVariantMap>("itemAdded", model, &ItemModel::onItemAdded);
+
+    QVariantMap item;
+    item["id"] = 1;
+    dispatcher.dispatch("itemAdded", QVariant(item));
+    dispatcher.dispatch("itemRemoved", QVariant(item));
+
+    // A message dispatched from JavaScript is converted to the type of the method.
+    dispatcher.dispatch("itemAdded", engine.evaluate("({id: 2})"));
+
+    QCOMPARE(model->items.size(), 2);
+    QCOMPARE(model->items.at(0).value("id").toInt(), 1);
+    QCOMPARE(model->items.at(1).value("id").toInt(), 2);
+
+    // The listener is skipped once its object is destroyed.
+    delete model;
+    dispatcher.dispatch("itemAdded", QVariant(item));
+}
+
+void TestDispatcher::nativeListenerRemovedDuringDelivery()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+    int first = 0;
+    int second = 0;
+    int third = 0;
+
+    first = dispatcher.addNativeListener(QStringList(), [&](const QString &, const QVariant &) {
+        log << "first";
+
+        // Removes itself and the next one. The listener added now waits for the next action.
+        dispatcher.removeNativeListener(first);
+        dispatcher.removeNativeListener(second);
+        third = dispatcher.addNativeListener(QStringList(), [&log](const QString &, const QVariant &) {
+            log << "added";
+        });
+    });
+    second = dispatcher.addNativeListener(QStringList() << "a", [&log](const QString &, const QVariant &) {
+        log << "second";
+    });
+    dispatcher.addNativeListener(QStringList() << "a", [&log](const QString &, const QVariant &) {
+        log << "kept";
+    });
+
+    dispatcher.dispatch("a", QVariant());
+    QCOMPARE(log, QStringList() << "first" << "kept");
+
+    dispatcher.dispatch("a", QVariant());
+    QCOMPARE(log, QStringList() << "first" << "kept" << "kept" << "added");
+    QVERIFY(third > 0);
+}
+
+void TestDispatcher::converterWithoutScriptListeners()
+{
+    QxActionCreator::registerConverter<Money>([](const Money &money) {
+        return QVariant(QVariantMap{{"amount", money.amount}, {"currency", money.currency}});
+    });
+
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QVariant received;
+
+    dispatcher.addNativeListener(QStringList() << "paid", [&received](const QString &, const QVariant &message) {
+        received = message;
+    });
+
+    // Completed after the converter is registered, as a creator declared in QML would be.
+    PaymentCreator creator;
+    QQmlEngine::setContextForObject(&creator, engine.rootContext());
+    creator.setDispatcher(&dispatcher);
+    static_cast<QQmlParserStatus *>(&creator)->componentComplete();
+
+    // Only C++ receives the action, so the message is built as a QVariantMap with the converted argument.
+    QVERIFY(!dispatcher.hasScriptListeners(dispatcher.typeAtom("paid")));
+    emit creator.paid(Money{100, "EUR"});
+
+    const QVariantMap money = received.toMap().value("money").toMap();
+    QCOMPARE(money.value("amount").toInt(), 100);
+    QCOMPARE(money.value("currency").toString(), QString("EUR"));
+}
+
+QList<QPair<QString, QVariant>> TestDispatcher::prepareBurst(QxDispatcher *dispatcher, int count, int *received)
+{
+    const QString type = "update";
+
+    for (int i = 0 ; i < 10 ; i++) {
+        QxListener *listener = new QxListener(dispatcher);
+        listener->setTypes(QList<int>() << dispatcher->typeAtom(type));
+        dispatcher->addListener(listener);
+
+        connect(listener, &QxListener::dispatched, this, [received]() {
+            (*received)++;
+        });
+    }
+
+    QList<QPair<QString, QVariant>> actions;
+
+    for (int i = 0 ; i < count ; i++) {
+        actions << qMakePair(type, QVariant(i));
+    }
+
+    return actions;
+}
+
+void TestDispatcher::benchmarkDispatchLoop()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    int received = 0;
+
+    const QList<QPair<QString, QVariant>> actions = prepareBurst(&dispatcher, 1000, &received);
+
+    QBENCHMARK {
+        for (const auto &action : actions) {
+            dispatcher.dispatch(action.first, action.second);
+        }
+    }
+
+    QVERIFY(received >= 10000);
+}
+
+void TestDispatcher::benchmarkDispatchBatch()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    int received = 0;
+
+    const QList<QPair<QString, QVariant>> actions = prepareBurst(&dispatcher, 1000, &received);
+
+    QBENCHMARK {
+        dispatcher.dispatchBatch(actions);
+    }
+
+    QVERIFY(received >= 10000);
+}
+
+QTEST_MAIN(TestDispatcher)
+
+#include "tst_dispatcher.moc"
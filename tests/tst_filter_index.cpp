@@ -0,0 +1,176 @@
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QtTest>
+
+#include "qx_atom_table.h"
+#include "qx_dispatcher.h"
+#include "qx_filter.h"
+#include "qx_filter_index.h"
+#include "qx_store.h"
+
+class TestFilterIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void indexesByType();
+    void keepsAddOrder();
+    void followsTypeChanges();
+    void followsRemovalAndDestruction();
+    void copyIsNotChanged();
+    void storeSkipsDestroyedFilter();
+
+private:
+    QxFilter *createFilter(QObject *parent, const QStringList &types);
+};
+
+QxFilter *TestFilterIndex::createFilter(QObject *parent, const QStringList &types)
+{
+    QxFilter *filter = new QxFilter(parent);
+    filter->setTypes(types);
+    return filter;
+}
+
+void TestFilterIndex::indexesByType()
+{
+    QxFilterIndex index;
+    QxFilter *ab = createFilter(&index, QStringList() << "a" << "b" << "a");
+    QxFilter *b = createFilter(&index, QStringList() << "b");
+    const int atomA = QxAtomTable::intern("a");
+    const int atomB = QxAtomTable::intern("b");
+    const int atomC = QxAtomTable::intern("c");
+
+    index.add(ab);
+    index.add(b);
+
+    QVERIFY(index.contains(atomA));
+    QVERIFY(index.contains(atomB));
+    QVERIFY(!index.contains(atomC));
+
+    // A type listed twice indexes the filter once.
+    QCOMPARE(index.filters(atomA), QList<QxFilter *>() << ab);
+    QCOMPARE(index.filters(atomB), QList<QxFilter *>() << ab << b);
+    QVERIFY(index.filters(atomC).isEmpty());
+
+    QVERIFY(index.contains(atomA, ab));
+    QVERIFY(!index.contains(atomA, b));
+
+    QList<int> atoms = index.atoms();
+    std::sort(atoms.begin(), atoms.end());
+    QList<int> expected = QList<int>() << atomA << atomB;
+    std::sort(expected.begin(), expected.end());
+    QCOMPARE(atoms, expected);
+}
+
+void TestFilterIndex::keepsAddOrder()
+{
+    QxFilterIndex index;
+    QxFilter *first = createFilter(&index, QStringList() << "a");
+    QxFilter *second = createFilter(&index, QStringList() << "a");
+    const int atom = QxAtomTable::intern("a");
+
+    index.add(first);
+    index.add(second);
+    index.add(first);
+
+    // Indexing the first one again, after its types changed, keeps it ahead of the second.
+    first->setTypes(QStringList() << "b" << "a");
+    QCOMPARE(index.filters(atom), QList<QxFilter *>() << first << second);
+}
+
+void TestFilterIndex::followsTypeChanges()
+{
+    QxFilterIndex index;
+    QxFilter *filter = createFilter(&index, QStringList() << "a");
+    const int atomA = QxAtomTable::intern("a");
+    const int atomB = QxAtomTable::intern("b");
+
+    index.add(filter);
+    QSignalSpy spy(&index, SIGNAL(changed()));
+
+    filter->setType("b");
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!index.contains(atomA));
+    QVERIFY(!index.contains(atomA, filter));
+    QCOMPARE(index.filters(atomB), QList<QxFilter *>() << filter);
+}
+
+void TestFilterIndex::followsRemovalAndDestruction()
+{
+    QxFilterIndex index;
+    QxFilter *removed = createFilter(&index, QStringList() << "a");
+    QxFilter *destroyed = createFilter(&index, QStringList() << "a");
+    const int atom = QxAtomTable::intern("a");
+
+    index.add(removed);
+    index.add(destroyed);
+    QSignalSpy spy(&index, SIGNAL(changed()));
+
+    index.remove(removed);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!index.contains(atom, removed));
+    QCOMPARE(index.filters(atom), QList<QxFilter *>() << destroyed);
+
+    // A removed filter is not followed anymore.
+    removed->setType("b");
+    QCOMPARE(spy.count(), 1);
+
+    delete destroyed;
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(!index.contains(atom));
+    QVERIFY(index.filters(atom).isEmpty());
+}
+
+void TestFilterIndex::copyIsNotChanged()
+{
+    QxFilterIndex index;
+    QxFilter *first = createFilter(&index, QStringList() << "a");
+    QxFilter *second = createFilter(&index, QStringList() << "a");
+    const int atom = QxAtomTable::intern("a");
+
+    index.add(first);
+    index.add(second);
+
+    // An owner delivers to a copy. It keeps the filters, and contains() tells which are still indexed.
+    const QList<QxFilter *> copy = index.filters(atom);
+    index.remove(first);
+
+    QCOMPARE(copy, QList<QxFilter *>() << first << second);
+    QVERIFY(!index.contains(atom, first));
+    QVERIFY(index.contains(atom, second));
+}
+
+void TestFilterIndex::storeSkipsDestroyedFilter()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QxStore store;
+    QStringList log;
+
+    QxFilter *first = createFilter(&store, QStringList() << "a");
+    QxFilter *second = createFilter(&store, QStringList() << "a");
+    store.filterIndex()->add(first);
+    store.filterIndex()->add(second);
+    store.setBindSource(&dispatcher);
+
+    connect(first, &QxFilter::dispatched, this, [&log, &second]() {
+        log << "first";
+        delete second;
+        second = nullptr;
+    });
+    connect(second, &QxFilter::dispatched, this, [&log]() {
+        log << "second";
+    });
+
+    // The second filter is destroyed while the action is delivered, so it is skipped.
+    dispatcher.dispatch("a", QVariant());
+    QCOMPARE(log, QStringList() << "first");
+
+    dispatcher.dispatch("a", QVariant());
+    QCOMPARE(log, QStringList() << "first" << "first");
+}
+
+QTEST_MAIN(TestFilterIndex)
+
+#include "tst_filter_index.moc"
@@ -0,0 +1,183 @@
+#include <QQmlEngine>
+#include <QThread>
+#include <QtTest>
+
+#include "qx_dispatcher.h"
+#include "qx_inbox.h"
+
+namespace {
+
+// The number of posted actions delivered per drainInbox() call, as in qx_dispatcher.cpp.
+const int BatchSize = 1024;
+
+const int ProducerCount = 4;
+
+const int ActionsPerProducer = 5000;
+
+} // namespace
+
+class TestInbox : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void producersKeepTheirOrder();
+    void postFromThreads();
+    void drainsInBatches();
+    void postDuringDrainIsScheduled();
+
+private:
+    // Check that every producer delivered its actions once, in order.
+    void verifyOrder(const QHash<QString, QList<int>> &received);
+
+    QList<QThread *> startProducers(std::function<void(const QString &type, int value)> post);
+};
+
+void TestInbox::verifyOrder(const QHash<QString, QList<int>> &received)
+{
+    QCOMPARE(received.size(), ProducerCount);
+
+    for (auto iter = received.constBegin() ; iter != received.constEnd() ; iter++) {
+        QCOMPARE(iter->size(), ActionsPerProducer);
+
+        for (int i = 0 ; i < ActionsPerProducer ; i++) {
+            QCOMPARE(iter->at(i), i);
+        }
+    }
+}
+
+QList<QThread *> TestInbox::startProducers(std::function<void(const QString &type, int value)> post)
+{
+    QList<QThread *> threads;
+
+    for (int i = 0 ; i < ProducerCount ; i++) {
+        const QString type = QString("producer%1").arg(i);
+
+        threads << QThread::create([post, type]() {
+            for (int value = 0 ; value < ActionsPerProducer ; value++) {
+                post(type, value);
+            }
+        });
+    }
+
+    for (QThread *thread : std::as_const(threads)) {
+        thread->start();
+    }
+
+    return threads;
+}
+
+void TestInbox::producersKeepTheirOrder()
+{
+    QxInbox inbox;
+    QHash<QString, QList<int>> received;
+    int count = 0;
+
+    const QList<QThread *> threads = startProducers([&inbox](const QString &type, int value) {
+        inbox.push(type, value);
+    });
+
+    // Pop while the producers are pushing.
+    QDeadlineTimer deadline(10000);
+    QxInbox::Item item;
+
+    while (count < ProducerCount * ActionsPerProducer && !deadline.hasExpired()) {
+        if (inbox.pop(&item)) {
+            received[item.type] << item.message.toInt();
+            count++;
+        }
+    }
+
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    QVERIFY(!inbox.pop(&item));
+    QVERIFY(inbox.isEmpty());
+    verifyOrder(received);
+}
+
+void TestInbox::postFromThreads()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QHash<QString, QList<int>> received;
+    int count = 0;
+
+    dispatcher.addNativeListener(QStringList(), [&](const QString &type, const QVariant &message) {
+        QCOMPARE(QThread::currentThread(), dispatcher.thread());
+        received[type] << message.toInt();
+        count++;
+    });
+
+    const QList<QThread *> threads = startProducers([&dispatcher](const QString &type, int value) {
+        dispatcher.post(type, value);
+    });
+
+    // The dispatcher drains while the producers are posting. A post racing a drain schedules another one.
+    QTRY_COMPARE_WITH_TIMEOUT(count, ProducerCount * ActionsPerProducer, 10000);
+
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    verifyOrder(received);
+}
+
+void TestInbox::drainsInBatches()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    int count = 0;
+
+    dispatcher.addNativeListener(QStringList(), [&count](const QString &, const QVariant &) {
+        count++;
+    });
+
+    for (int i = 0 ; i < BatchSize * 2 + 10 ; i++) {
+        dispatcher.post("test", i);
+    }
+
+    QCOMPARE(count, 0);
+
+    QVERIFY(QMetaObject::invokeMethod(&dispatcher, "drainInbox", Qt::DirectConnection));
+    QCOMPARE(count, BatchSize);
+
+    QVERIFY(QMetaObject::invokeMethod(&dispatcher, "drainInbox", Qt::DirectConnection));
+    QCOMPARE(count, BatchSize * 2);
+
+    // A full batch schedules the next drain, so the rest arrives without another post.
+    QTRY_COMPARE(count, BatchSize * 2 + 10);
+}
+
+void TestInbox::postDuringDrainIsScheduled()
+{
+    QQmlEngine engine;
+    QxDispatcher dispatcher;
+    dispatcher.setEngine(&engine);
+    QStringList log;
+
+    dispatcher.addNativeListener(QStringList(), [&](const QString &type, const QVariant &) {
+        log << type;
+
+        // Posted while the inbox is drained. It is not lost, and a drain is scheduled for it.
+        if (type == "ping") {
+            dispatcher.post("pong");
+        }
+    });
+
+    dispatcher.post("ping");
+    QTRY_COMPARE(log, QStringList() << "ping" << "pong");
+
+    // The inbox is idle again, and the next post schedules a drain.
+    dispatcher.post("again");
+    QTRY_COMPARE(log, QStringList() << "ping" << "pong" << "again");
+}
+
+QTEST_MAIN(TestInbox)
+
+#include "tst_inbox.moc"
@@ -0,0 +1,260 @@
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QtTest>
+
+#include "qx_atom_table.h"
+#include "qx_debounce.h"
+#include "qx_dedupe.h"
+#include "qx_middlewares_hook.h"
+#include "qx_throttle.h"
+
+namespace {
+
+// Short enough to keep the tests fast, long enough for a burst of synchronous dispatches.
+const int Interval = 50;
+
+} // namespace
+
+class TestKeyedMiddlewares : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void throttleLeadingAndTrailing();
+    void throttleTrailingOnly();
+    void throttleLeadingOnly();
+    void throttleWithoutEdgesPassesOn();
+    void throttleKeyPath();
+    void throttleOtherTypesPassOn();
+    void debounceTrailing();
+    void debounceLeading();
+    void dedupeWholeMessage();
+    void dedupeKeyPath();
+    void dedupeZeroInterval();
+
+private:
+    // Place the middleware in the chain. It is owned by the list.
+    void setup(QxKeyedMiddleware *middleware);
+
+    // Dispatch an action with the message {id, value}.
+    void dispatch(const QString &type, int id, int value);
+
+    QQmlEngine *engine_ = nullptr;
+    QQuickItem *list_ = nullptr;
+    QxMiddlewaresHook *hook_ = nullptr;
+
+    // Delivered actions as "type=value".
+    QStringList delivered_;
+};
+
+void TestKeyedMiddlewares::init()
+{
+    engine_ = new QQmlEngine;
+    list_ = new QQuickItem;
+    hook_ = new QxMiddlewaresHook;
+    delivered_.clear();
+
+    connect(hook_, &QxHook::actionDispatched, this, [this](const QxAction &action) {
+        delivered_ << QString("%1=%2").arg(action.type(), action.payload().toMap().value("value").toString());
+    });
+}
+
+void TestKeyedMiddlewares::cleanup()
+{
+    delete hook_;
+    delete list_;
+    delete engine_;
+}
+
+void TestKeyedMiddlewares::setup(QxKeyedMiddleware *middleware)
+{
+    middleware->setParent(list_);
+    middleware->setParentItem(list_);
+    middleware->setInterval(Interval);
+    hook_->setup(engine_, list_);
+}
+
+void TestKeyedMiddlewares::dispatch(const QString &type, int id, int value)
+{
+    QVariantMap message;
+    message["id"] = id;
+    message["value"] = value;
+    hook_->dispatch(QxAction(QxAtomTable::intern(type), message), nullptr);
+}
+
+void TestKeyedMiddlewares::throttleLeadingAndTrailing()
+{
+    setup(new QxThrottle);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    dispatch("a", 0, 3);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    // The latest suppressed action is passed when the window closes.
+    QTRY_COMPARE(delivered_, QStringList() << "a=1" << "a=3");
+}
+
+void TestKeyedMiddlewares::throttleTrailingOnly()
+{
+    QxThrottle *throttle = new QxThrottle;
+    throttle->setLeading(false);
+    setup(throttle);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    QCOMPARE(delivered_, QStringList());
+
+    QTRY_COMPARE(delivered_, QStringList() << "a=2");
+}
+
+void TestKeyedMiddlewares::throttleLeadingOnly()
+{
+    QxThrottle *throttle = new QxThrottle;
+    throttle->setTrailing(false);
+    setup(throttle);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    // Suppressed actions are dropped, and the next action after the window is passed.
+    QTest::qWait(Interval * 3);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    dispatch("a", 0, 3);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=3");
+}
+
+void TestKeyedMiddlewares::throttleWithoutEdgesPassesOn()
+{
+    QxThrottle *throttle = new QxThrottle;
+    throttle->setLeading(false);
+    throttle->setTrailing(false);
+    setup(throttle);
+
+    // It warns once, and does not drop every action.
+    QTest::ignoreMessage(QtWarningMsg, "QxThrottle: Neither leading nor trailing is enabled. Actions are not throttled.");
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=2");
+}
+
+void TestKeyedMiddlewares::throttleKeyPath()
+{
+    QxThrottle *throttle = new QxThrottle;
+    throttle->setKeyPath("id");
+    setup(throttle);
+
+    // Each id has a window of its own.
+    dispatch("a", 1, 1);
+    dispatch("a", 2, 2);
+    dispatch("a", 1, 3);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=2");
+
+    QTRY_COMPARE(delivered_, QStringList() << "a=1" << "a=2" << "a=3");
+}
+
+void TestKeyedMiddlewares::throttleOtherTypesPassOn()
+{
+    QxThrottle *throttle = new QxThrottle;
+    throttle->setTypes(QStringList() << "a");
+    setup(throttle);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    dispatch("b", 0, 3);
+    dispatch("b", 0, 4);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "b=3" << "b=4");
+
+    QTRY_COMPARE(delivered_, QStringList() << "a=1" << "b=3" << "b=4" << "a=2");
+}
+
+void TestKeyedMiddlewares::debounceTrailing()
+{
+    setup(new QxDebounce);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    dispatch("a", 0, 3);
+    QCOMPARE(delivered_, QStringList());
+
+    QTRY_COMPARE(delivered_, QStringList() << "a=3");
+
+    // A new burst starts once the type has been quiet.
+    dispatch("a", 0, 4);
+    QCOMPARE(delivered_, QStringList() << "a=3");
+    QTRY_COMPARE(delivered_, QStringList() << "a=3" << "a=4");
+}
+
+void TestKeyedMiddlewares::debounceLeading()
+{
+    QxDebounce *debounce = new QxDebounce;
+    debounce->setLeading(true);
+    debounce->setTrailing(false);
+    setup(debounce);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    QTest::qWait(Interval * 3);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    dispatch("a", 0, 3);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=3");
+}
+
+void TestKeyedMiddlewares::dedupeWholeMessage()
+{
+    setup(new QxDedupe);
+
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 2);
+    dispatch("b", 0, 1);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=2" << "b=1");
+
+    // It is forgotten after the interval.
+    QTest::qWait(Interval * 3);
+
+    dispatch("a", 0, 1);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=2" << "b=1" << "a=1");
+}
+
+void TestKeyedMiddlewares::dedupeKeyPath()
+{
+    QxDedupe *dedupe = new QxDedupe;
+    dedupe->setKeyPath("id");
+    setup(dedupe);
+
+    // Only the value at keyPath is compared.
+    dispatch("a", 1, 1);
+    dispatch("a", 1, 2);
+    dispatch("a", 2, 3);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=3");
+}
+
+void TestKeyedMiddlewares::dedupeZeroInterval()
+{
+    QxDedupe *dedupe = new QxDedupe;
+    setup(dedupe);
+    dedupe->setInterval(0);
+
+    // Duplicates dispatched before control returns to the event loop are dropped.
+    dispatch("a", 0, 1);
+    dispatch("a", 0, 1);
+    QCOMPARE(delivered_, QStringList() << "a=1");
+
+    QTest::qWait(10);
+
+    dispatch("a", 0, 1);
+    QCOMPARE(delivered_, QStringList() << "a=1" << "a=1");
+}
+
+QTEST_MAIN(TestKeyedMiddlewares)
+
+#include "tst_keyed_middlewares.moc"
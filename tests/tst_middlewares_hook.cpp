@@ -0,0 +1,198 @@
+#include <QPromise>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QtTest>
+
+#include "qx_native_middleware.h"
+#include "qx_atom_table.h"
+#include "qx_middlewares_hook.h"
+
+// Keeps every action in flight until the test settles it.
+class PendingMiddleware : public QxNativeMiddleware
+{
+    Q_OBJECT
+public:
+    void dispatch(const QxAction &action) override
+    {
+        received << action.type();
+
+        QSharedPointer<QPromise<void>> promise(new QPromise<void>);
+        promise->start();
+        track(promise->future());
+        promises << promise;
+
+        next(action);
+    }
+
+    void settle(int index)
+    {
+        promises.at(index)->finish();
+    }
+
+    QStringList received;
+    QList<QSharedPointer<QPromise<void>>> promises;
+};
+
+class TestMiddlewaresHook : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void orderedAdmitsOneAtATime();
+    void maxConcurrency();
+    void staleSettleAfterSetup();
+    void backlogPassesToNewChain();
+    void nativeChainHasNoScriptHandlers();
+
+private:
+    void dispatch(const QString &type);
+
+    QQmlEngine *engine_ = nullptr;
+    QQuickItem *list_ = nullptr;
+    PendingMiddleware *middleware_ = nullptr;
+    QxMiddlewaresHook *hook_ = nullptr;
+    QStringList delivered_;
+};
+
+void TestMiddlewaresHook::init()
+{
+    engine_ = new QQmlEngine;
+    list_ = new QQuickItem;
+    middleware_ = new PendingMiddleware;
+    middleware_->setParentItem(list_);
+    hook_ = new QxMiddlewaresHook;
+    delivered_.clear();
+
+    connect(hook_, &QxHook::actionDispatched, this, [this](const QxAction &action) {
+        delivered_ << action.type();
+    });
+}
+
+void TestMiddlewaresHook::cleanup()
+{
+    delete hook_;
+    delete middleware_;
+    delete list_;
+    delete engine_;
+}
+
+void TestMiddlewaresHook::dispatch(const QString &type)
+{
+    hook_->dispatch(QxAction(QxAtomTable::intern(type), QVariant()), nullptr);
+}
+
+void TestMiddlewaresHook::orderedAdmitsOneAtATime()
+{
+    hook_->setup(engine_, list_);
+
+    dispatch("a");
+    dispatch("b");
+    dispatch("c");
+
+    QCOMPARE(middleware_->received, QStringList() << "a");
+    QCOMPARE(hook_->pendingCount(), 3);
+
+    middleware_->settle(0);
+    QTRY_COMPARE(middleware_->received, QStringList() << "a" << "b");
+    QCOMPARE(hook_->pendingCount(), 2);
+
+    middleware_->settle(1);
+    QTRY_COMPARE(middleware_->received, QStringList() << "a" << "b" << "c");
+
+    middleware_->settle(2);
+    QTRY_COMPARE(hook_->pendingCount(), 0);
+    QCOMPARE(delivered_, QStringList() << "a" << "b" << "c");
+}
+
+void TestMiddlewaresHook::maxConcurrency()
+{
+    middleware_->setOrdered(false);
+    middleware_->setMaxConcurrency(2);
+    hook_->setup(engine_, list_);
+
+    dispatch("a");
+    dispatch("b");
+    dispatch("c");
+
+    QCOMPARE(middleware_->received, QStringList() << "a" << "b");
+    QCOMPARE(hook_->pendingCount(), 3);
+
+    // Any settled action frees a slot, not only the oldest one.
+    middleware_->settle(1);
+    QTRY_COMPARE(middleware_->received, QStringList() << "a" << "b" << "c");
+    QCOMPARE(hook_->pendingCount(), 2);
+
+    middleware_->settle(0);
+    middleware_->settle(2);
+    QTRY_COMPARE(hook_->pendingCount(), 0);
+}
+
+void TestMiddlewaresHook::staleSettleAfterSetup()
+{
+    hook_->setup(engine_, list_);
+
+    dispatch("a");
+    QCOMPARE(hook_->pendingCount(), 1);
+
+    // A new chain starts with no action in flight.
+    hook_->setup(engine_, list_);
+    QCOMPARE(hook_->pendingCount(), 0);
+
+    dispatch("b");
+    QCOMPARE(middleware_->received, QStringList() << "a" << "b");
+
+    // Settling the action of the previous chain does not free the slot held by b.
+    middleware_->settle(0);
+    QTest::qWait(20);
+
+    dispatch("c");
+    QCOMPARE(middleware_->received, QStringList() << "a" << "b");
+    QCOMPARE(hook_->pendingCount(), 2);
+
+    middleware_->settle(1);
+    QTRY_COMPARE(middleware_->received, QStringList() << "a" << "b" << "c");
+}
+
+void TestMiddlewaresHook::backlogPassesToNewChain()
+{
+    hook_->setup(engine_, list_);
+
+    dispatch("a");
+    dispatch("b");
+    dispatch("c");
+    QCOMPARE(hook_->pendingCount(), 3);
+
+    // a is in flight and not tracked anymore. b and c waited, so they enter the new chain in order.
+    hook_->setup(engine_, list_);
+    QCOMPARE(middleware_->received, QStringList() << "a" << "b");
+    QCOMPARE(hook_->pendingCount(), 2);
+
+    middleware_->settle(1);
+    QTRY_COMPARE(middleware_->received, QStringList() << "a" << "b" << "c");
+
+    middleware_->settle(2);
+    QTRY_COMPARE(hook_->pendingCount(), 0);
+    QCOMPARE(delivered_, QStringList() << "a" << "b" << "c");
+
+    // Without a chain, waiting actions are delivered.
+    dispatch("d");
+    dispatch("e");
+    hook_->setup(engine_, nullptr);
+    QCOMPARE(delivered_, QStringList() << "a" << "b" << "c" << "d" << "e");
+}
+
+void TestMiddlewaresHook::nativeChainHasNoScriptHandlers()
+{
+    QVERIFY(!hook_->hasScriptHandlers(QxAtomTable::intern("a")));
+
+    // A native middleware does not need the message as a JavaScript value.
+    hook_->setup(engine_, list_);
+    QVERIFY(!hook_->hasScriptHandlers(QxAtomTable::intern("a")));
+}
+
+QTEST_MAIN(TestMiddlewaresHook)
+
+#include "tst_middlewares_hook.moc"
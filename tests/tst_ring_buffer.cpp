@@ -0,0 +1,69 @@
+#include <QtTest>
+
+#include "qx_ring_buffer.h"
+
+class TestRingBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void wraparound();
+    void full();
+    void rounds();
+};
+
+void TestRingBuffer::wraparound()
+{
+    QxRingBuffer ring(8);
+    char data[8];
+
+    QVERIFY(ring.write("abcdef", 6));
+    QCOMPARE(ring.read(data, 4), qsizetype(4));
+    QCOMPARE(QByteArray(data, 4), QByteArray("abcd"));
+
+    // Written across the end of the buffer.
+    QVERIFY(ring.write("ghijk", 5));
+    QCOMPARE(ring.size(), qsizetype(7));
+
+    QCOMPARE(ring.read(data, sizeof(data)), qsizetype(7));
+    QCOMPARE(QByteArray(data, 7), QByteArray("efghijk"));
+    QCOMPARE(ring.size(), qsizetype(0));
+}
+
+void TestRingBuffer::full()
+{
+    QxRingBuffer ring(8);
+    char data[8];
+
+    QVERIFY(ring.write("01234567", 8));
+    QVERIFY(!ring.write("8", 1));
+    QCOMPARE(ring.size(), qsizetype(8));
+
+    QCOMPARE(ring.read(data, 3), qsizetype(3));
+
+    // A record is written entirely or not at all.
+    QVERIFY(!ring.write("abcd", 4));
+    QCOMPARE(ring.size(), qsizetype(5));
+    QVERIFY(ring.write("abc", 3));
+
+    QCOMPARE(ring.read(data, sizeof(data)), qsizetype(8));
+    QCOMPARE(QByteArray(data, 8), QByteArray("34567abc"));
+}
+
+void TestRingBuffer::rounds()
+{
+    QxRingBuffer ring(64);
+    QByteArray data(64, Qt::Uninitialized);
+
+    for (int i = 0 ; i < 1000 ; i++) {
+        const QByteArray record = QByteArray::number(i).repeated(i % 7 + 1);
+
+        QVERIFY(ring.write(record.constData(), record.size()));
+        QCOMPARE(ring.read(data.data(), data.size()), record.size());
+        QCOMPARE(data.left(record.size()), record);
+    }
+}
+
+QTEST_MAIN(TestRingBuffer)
+
+#include "tst_ring_buffer.moc"